@@ -0,0 +1,74 @@
+#!/usr/bin/nodejs
+const fs = require('fs');
+
+/**
+ * Compares a 'make bench' CSV against the checked-in baseline.
+ * Usage: bench_compare.js <baseline.csv> <current.csv> [tolerance%]
+ * Exits with 1 if any scenario is slower than the baseline beyond the tolerance.
+ * A baseline without scenarios (not recorded yet) is reported and nothing is
+ * compared; it only fails with BENCH_STRICT=1.
+ */
+
+/**
+ * Reads a bench CSV file.
+ * @param {string} file The CSV file path.
+ * @returns {Map<string, object>} Rows by scenario name.
+ */
+function readCsv(file) {
+	const rows = new Map();
+	if (!fs.existsSync(file)) return rows;
+	const lines = fs.readFileSync(file, 'utf8').split(/\r?\n/).filter(line => line.trim() !== '');
+	const header = lines.shift().split(',');
+	for (const line of lines) {
+		const values = line.split(',');
+		const row = {};
+		header.forEach((name, i) => row[name] = values[i]);
+		rows.set(row.scenario, row);
+	}
+	return rows;
+}
+
+const [baselineFile, currentFile, toleranceArg] = process.argv.slice(2);
+if (!baselineFile || !currentFile) {
+	console.error('Usage: bench_compare.js <baseline.csv> <current.csv> [tolerance%]');
+	process.exit(2);
+}
+const tolerance = parseFloat(toleranceArg ?? process.env.BENCH_TOLERANCE ?? '5');
+const baseline = readCsv(baselineFile);
+const current = readCsv(currentFile);
+let regressions = 0;
+
+// An empty baseline would report every scenario as new: nothing to compare
+if (!baseline.size) {
+	console.error(`${baselineFile} has no scenarios, nothing compared: record it with the matching '-baseline' make target`);
+	process.exit(process.env.BENCH_STRICT === '1' ? 1 : 0);
+}
+
+console.log('Scenario'.padEnd(16) + 'Baseline cyc'.padStart(14) + 'Current cyc'.padStart(14) + 'Delta'.padStart(10) + 'Frames'.padStart(10));
+for (const [name, row] of current) {
+	const base = baseline.get(name);
+	const cycles = parseInt(row.cycles358);
+	let baseText = '-', deltaText = 'new';
+	if (base) {
+		const baseCycles = parseInt(base.cycles358);
+		const delta = (cycles - baseCycles) * 100 / baseCycles;
+		baseText = String(baseCycles);
+		deltaText = (delta >= 0 ? '+' : '') + delta.toFixed(1) + '%';
+		if (delta > tolerance) {
+			deltaText += ' !';
+			regressions++;
+		}
+	}
+	console.log(name.padEnd(16) + baseText.padStart(14) + String(cycles).padStart(14) + deltaText.padStart(10) + row.frames.padStart(10));
+}
+for (const name of baseline.keys()) {
+	if (!current.has(name)) {
+		console.log(name.padEnd(16) + 'missing in current run');
+		regressions++;
+	}
+}
+
+if (regressions) {
+	console.error(`${regressions} scenario(s) regressed more than ${tolerance}% against ${baselineFile}`);
+	process.exit(1);
+}
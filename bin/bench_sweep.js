@@ -0,0 +1,143 @@
+#!/usr/bin/nodejs
+const fs = require('fs');
+const path = require('path');
+const crypto = require('crypto');
+const { spawnSync } = require('child_process');
+
+/**
+ * Runs the bench scenarios on every OCM machine preset (emulation/ocm_machines.txt)
+ * and compares the 3.58MHz clock cycles and the screen hashes against a baseline.
+ * Usage: bench_sweep.js <output dir> <baseline.csv|-> -- <openMSX command line>
+ * The presets can be limited with SWEEP_MACHINES=name,name,...
+ * Exits with 1 if a scenario is slower than the baseline beyond the tolerance
+ * (BENCH_TOLERANCE, default 5%) or a screen differs from the baseline. A baseline
+ * without rows (not recorded yet) is reported and nothing is compared; it only
+ * fails with BENCH_STRICT=1. With '-' as baseline the results are only recorded.
+ */
+
+const machinesPath = path.join(__dirname, '..', 'emulation', 'ocm_machines.txt');
+const HASH_LENGTH = 16;
+
+/**
+ * Reads the preset names of the machine presets file.
+ * @param {string} file The presets file path.
+ * @returns {string[]} The preset names, in file order.
+ */
+function readMachineNames(file) {
+	return fs.readFileSync(file, 'utf8').split(/\r?\n/)
+		.map(line => line.trim().split(/\s+/)[0])
+		.filter(name => name && !name.startsWith('#'));
+}
+
+/**
+ * Reads a CSV file.
+ * @param {string} file The CSV file path.
+ * @returns {object[]} The rows, as objects by column name.
+ */
+function readCsv(file) {
+	if (!fs.existsSync(file)) return [];
+	const lines = fs.readFileSync(file, 'utf8').split(/\r?\n/).filter(line => line.trim() !== '');
+	const header = lines.shift().split(',');
+	return lines.map(line => {
+		const values = line.split(',');
+		const row = {};
+		header.forEach((name, i) => row[name] = values[i]);
+		return row;
+	});
+}
+
+/**
+ * Runs the bench on a machine preset.
+ * @param {string} machine The preset name.
+ * @param {string} outDir The output directory.
+ * @param {string[]} command The openMSX command line.
+ * @returns {object[]} Sweep rows: {machine, kind, name, value}.
+ */
+function runMachine(machine, outDir, command) {
+	const csvFile = path.join(outDir, `${machine}.csv`);
+	const screensDir = path.join(outDir, machine);
+	fs.rmSync(screensDir, { recursive: true, force: true });
+	fs.rmSync(csvFile, { force: true });
+
+	console.log(`#### ${machine}`);
+	const result = spawnSync(command[0], command.slice(1), {
+		stdio: 'inherit',
+		env: { ...process.env, OCM_MACHINE: machine, BENCH_CSV: csvFile, BENCH_SCREENS: screensDir },
+	});
+	if (result.status !== 0) {
+		console.error(`${machine}: the bench run failed (exit code ${result.status})`);
+		return [{ machine, kind: 'error', name: 'run', value: String(result.status) }];
+	}
+
+	const rows = readCsv(csvFile).map(row => ({ machine, kind: 'cycles358', name: row.scenario, value: row.cycles358 }));
+	if (fs.existsSync(screensDir)) {
+		for (const file of fs.readdirSync(screensDir).filter(file => file.endsWith('.bin')).sort()) {
+			const hash = crypto.createHash('sha1').update(fs.readFileSync(path.join(screensDir, file))).digest('hex');
+			rows.push({ machine, kind: 'screen', name: path.basename(file, '.bin'), value: hash.substring(0, HASH_LENGTH) });
+		}
+	}
+	return rows;
+}
+
+const separator = process.argv.indexOf('--');
+const [outDir, baselineFile] = process.argv.slice(2, separator < 0 ? undefined : separator);
+const command = separator < 0 ? [] : process.argv.slice(separator + 1);
+if (!outDir || !baselineFile || !command.length) {
+	console.error('Usage: bench_sweep.js <output dir> <baseline.csv|-> -- <openMSX command line>');
+	process.exit(2);
+}
+const tolerance = parseFloat(process.env.BENCH_TOLERANCE ?? '5');
+const machines = process.env.SWEEP_MACHINES ? process.env.SWEEP_MACHINES.split(',') : readMachineNames(machinesPath);
+
+fs.mkdirSync(outDir, { recursive: true });
+const rows = machines.flatMap(machine => runMachine(machine, outDir, command));
+const sweepFile = path.join(outDir, 'sweep.csv');
+fs.writeFileSync(sweepFile, 'machine,kind,name,value\n' + rows.map(row => `${row.machine},${row.kind},${row.name},${row.value}`).join('\n') + '\n');
+
+console.log(`\nSweep results: ${sweepFile}`);
+if (baselineFile === '-') process.exit(0);
+
+// Compare against the baseline. An empty one would report everything as new: nothing to compare
+const key = row => `${row.machine}/${row.kind}/${row.name}`;
+const baseline = new Map(readCsv(baselineFile).map(row => [key(row), row]));
+let regressions = 0, screens = 0;
+if (!baseline.size) {
+	console.error(`${baselineFile} has no rows, nothing compared: record it with 'make sweep-baseline'`);
+	process.exit(process.env.BENCH_STRICT === '1' ? 1 : 0);
+}
+
+console.log('\n' + 'Machine'.padEnd(14) + 'Scenario'.padEnd(16) + 'Baseline cyc'.padStart(13) + 'Current cyc'.padStart(13) + 'Delta'.padStart(10));
+for (const row of rows) {
+	const base = baseline.get(key(row));
+	if (row.kind === 'error') {
+		console.log(row.machine.padEnd(14) + 'run failed');
+		regressions++;
+	} else if (row.kind === 'cycles358') {
+		let baseText = '-', deltaText = 'new';
+		if (base) {
+			const delta = (parseInt(row.value) - parseInt(base.value)) * 100 / parseInt(base.value);
+			baseText = base.value;
+			deltaText = (delta >= 0 ? '+' : '') + delta.toFixed(1) + '%';
+			if (delta > tolerance) {
+				deltaText += ' !';
+				regressions++;
+			}
+		}
+		console.log(row.machine.padEnd(14) + row.name.padEnd(16) + baseText.padStart(13) + row.value.padStart(13) + deltaText.padStart(10));
+	} else if (base && base.value !== row.value) {
+		console.log(row.machine.padEnd(14) + row.name.padEnd(16) + `screen changed: ${base.value} -> ${row.value}`);
+		screens++;
+	}
+}
+const current = new Set(rows.map(key));
+for (const [name, row] of baseline) {
+	if (machines.includes(row.machine) && !current.has(name)) {
+		console.log(row.machine.padEnd(14) + row.name.padEnd(16) + `${row.kind} missing in current run`);
+		regressions++;
+	}
+}
+
+if (regressions || screens) {
+	console.error(`${regressions} regression(s) beyond ${tolerance}% and ${screens} changed screen(s) against ${baselineFile}`);
+	process.exit(1);
+}
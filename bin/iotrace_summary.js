@@ -0,0 +1,149 @@
+#!/usr/bin/nodejs
+const fs = require('fs');
+
+/**
+ * Summarizes an OCM I/O trace recorded by emulation/ocm_ioports.tcl.
+ * Usage: iotrace_summary.js <trace file>
+ * Shows the accesses by port, by user action (keys & bench marks), the
+ * redundant 0x40 selects, and the repeated reads of ports that did not change.
+ */
+
+const TRACE_MAGIC = 'OCMT';
+const RECORD_SIZE = 9;
+const TRACE_READ = 0, TRACE_WRITE = 1, TRACE_KEY = 2, TRACE_MARK = 3;
+const TOP_PCS = 8;
+
+/**
+ * Reads a trace file.
+ * @param {string} file The trace file path.
+ * @returns {object[]} Records: {type, port, value, pc, time, text}.
+ */
+function readTrace(file) {
+	const data = fs.readFileSync(file);
+	if (data.toString('latin1', 0, 4) !== TRACE_MAGIC) {
+		throw new Error(`${file} is not an OCM I/O trace`);
+	}
+	const records = [];
+	let pos = 5;
+	while (pos + RECORD_SIZE <= data.length) {
+		const record = {
+			type: data[pos],
+			port: data[pos + 1],
+			value: data[pos + 2],
+			pc: data.readUInt16LE(pos + 3),
+			time: data.readUInt32LE(pos + 5),
+		};
+		pos += RECORD_SIZE;
+		if (record.type === TRACE_MARK) {
+			record.text = data.toString('latin1', pos, pos + record.port);
+			pos += record.port;
+		}
+		records.push(record);
+	}
+	return records;
+}
+
+const hex = (value, digits = 2) => '0x' + value.toString(16).toUpperCase().padStart(digits, '0');
+
+/**
+ * Increments a counter in a Map.
+ * @param {Map} map The counters.
+ * @param {*} key The counter key.
+ */
+function count(map, key) {
+	map.set(key, (map.get(key) ?? 0) + 1);
+}
+
+/**
+ * Prints the top PCs of a counter map.
+ * @param {Map<number, number>} pcs Counters by PC.
+ */
+function printPcs(pcs) {
+	[...pcs].sort((a, b) => b[1] - a[1]).slice(0, TOP_PCS).forEach(([pc, n]) => {
+		console.log('    PC ' + hex(pc, 4) + String(n).padStart(10));
+	});
+}
+
+const [traceFile] = process.argv.slice(2);
+if (!traceFile) {
+	console.error('Usage: iotrace_summary.js <trace file>');
+	process.exit(2);
+}
+const records = readTrace(traceFile);
+
+const byPort = new Map();
+const actions = [];
+let action = { label: '[start]', reads: 0, writes: 0, start: records.length ? records[0].time : 0, end: 0 };
+actions.push(action);
+
+let selectedId = -1, port4bId = -1;
+let generation = 0;								// Increased at every write
+const lastRead = new Map();						// port context -> {value, generation}
+let redundantSelects = 0, repeatedReads = 0;
+const redundantPcs = new Map(), repeatedPcs = new Map(), repeatedPorts = new Map();
+
+for (const rec of records) {
+	if (rec.type === TRACE_KEY || rec.type === TRACE_MARK) {
+		action.end = rec.time;
+		const label = rec.type === TRACE_MARK ? `[${rec.text}]` :
+			(rec.value >= 0x20 && rec.value < 0x7f ? `key '${String.fromCharCode(rec.value)}'` : `key ${hex(rec.value)}`);
+		action = { label, reads: 0, writes: 0, start: rec.time, end: rec.time };
+		actions.push(action);
+		continue;
+	}
+	action.end = rec.time;
+	const stats = byPort.get(rec.port) ?? { reads: 0, writes: 0 };
+	byPort.set(rec.port, stats);
+
+	if (rec.type === TRACE_WRITE) {
+		stats.writes++;
+		action.writes++;
+		if (rec.port === 0x40) {
+			if (rec.value === selectedId) {
+				redundantSelects++;
+				count(redundantPcs, rec.pc);
+				continue;
+			}
+			selectedId = rec.value;
+		} else if (rec.port === 0x44) {
+			port4bId = rec.value;
+		}
+		generation++;
+	} else if (rec.type === TRACE_READ) {
+		stats.reads++;
+		action.reads++;
+		const context = `${rec.port}:${selectedId}:${rec.port === 0x4b ? port4bId : ''}`;
+		const last = lastRead.get(context);
+		if (last && last.generation === generation && last.value === rec.value) {
+			repeatedReads++;
+			count(repeatedPcs, rec.pc);
+			count(repeatedPorts, rec.port);
+		}
+		lastRead.set(context, { value: rec.value, generation });
+	}
+}
+
+const accesses = records.filter(rec => rec.type === TRACE_READ || rec.type === TRACE_WRITE).length;
+console.log(`${traceFile}: ${accesses} accesses, ${actions.length - 1} actions\n`);
+
+console.log('Port' + 'Reads'.padStart(10) + 'Writes'.padStart(10));
+[...byPort.keys()].sort((a, b) => a - b).forEach(port => {
+	const stats = byPort.get(port);
+	console.log(hex(port) + String(stats.reads).padStart(10) + String(stats.writes).padStart(10));
+});
+
+console.log('\n' + 'Action'.padEnd(24) + 'Reads'.padStart(8) + 'Writes'.padStart(8) + 'usecs'.padStart(10));
+for (const act of actions) {
+	if (!act.reads && !act.writes) continue;
+	console.log(act.label.padEnd(24) + String(act.reads).padStart(8) + String(act.writes).padStart(8) +
+		String(act.end - act.start).padStart(10));
+}
+
+console.log(`\nRedundant 0x40 selects: ${redundantSelects}`);
+printPcs(redundantPcs);
+
+console.log(`\nRepeated reads of unchanged ports: ${repeatedReads}`);
+[...repeatedPorts].sort((a, b) => a[0] - b[0]).forEach(([port, n]) => {
+	console.log('    ' + hex(port) + String(n).padStart(14));
+});
+printPcs(repeatedPcs);
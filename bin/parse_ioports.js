@@ -0,0 +1,150 @@
+#!/usr/bin/nodejs
+const fs = require('fs');
+const path = require('path');
+
+/**
+ * Generates the C table of the OCM switched I/O ports for the host harness
+ * from emulation/ocm_ioports.tcl, so both emulations share the same initial
+ * port values and smart command effects.
+ * The initial values are those of the machine preset (emulation/ocm_machines.txt)
+ * given as argument, or the default one.
+ * Usage: parse_ioports.js [ocm_ioports.tcl] [output.h] [machine]
+ */
+
+const inputTclPath = process.argv[2] ?? path.join(__dirname, '..', 'emulation', 'ocm_ioports.tcl');
+const outputHPath = process.argv[3] ?? path.join(__dirname, '..', 'obj', 'harness', 'ocm_ioports_table.h');
+const machinesPath = path.join(path.dirname(inputTclPath), 'ocm_machines.txt');
+const machineName = process.argv[4] || process.env.OCM_MACHINE || '';
+
+/**
+ * Parses a Tcl integer (decimal, 0x hexadecimal or 0b binary).
+ * @param {string} text The number text.
+ * @returns {number} The value.
+ */
+function parseNumber(text) {
+	if (/^0b[01]+$/i.test(text)) return parseInt(text.substring(2), 2);
+	return Number(text);
+}
+
+/**
+ * Returns the body of an 'array set NAME { ... }' block, without comment lines.
+ * @param {string} tcl The Tcl source.
+ * @param {string} name The array name.
+ * @returns {string} The block body.
+ */
+function arrayBlock(tcl, name) {
+	const start = tcl.indexOf(`array set ${name} {`);
+	if (start < 0) throw new Error(`'array set ${name}' not found in ${inputTclPath}`);
+	let pos = tcl.indexOf('{', start) + 1, depth = 1;
+	const begin = pos;
+	while (depth && pos < tcl.length) {
+		if (tcl[pos] === '{') depth++;
+		if (tcl[pos] === '}') depth--;
+		pos++;
+	}
+	return tcl.substring(begin, pos - 1)
+		.split('\n')
+		.filter(line => !line.trim().startsWith('#'))
+		.join('\n');
+}
+
+/**
+ * Reads the machine presets file, as ocm_ioports::load_machines does.
+ * @param {string} file The presets file path.
+ * @returns {Map<string, string[]>} Preset fields by name, in file order.
+ */
+function readMachines(file) {
+	const machines = new Map();
+	for (const line of fs.readFileSync(file, 'utf8').split(/\r?\n/)) {
+		const fields = line.trim().split(/\s+/);
+		if (!fields[0] || fields[0].startsWith('#')) continue;
+		if (fields.length < 5) throw new Error(`Bad machine preset in ${file}: ${line}`);
+		machines.set(fields[0], fields.slice(1));
+	}
+	return machines;
+}
+
+/**
+ * Applies a machine preset over the initial port values, as ocm_ioports::apply_machine does.
+ * @param {Map<number, number>} ports The port values.
+ * @param {string[]} fields The preset fields: machine iorev pld sdram [port=value ...].
+ */
+function applyMachine(ports, [type, iorev, pld, sdram, ...overrides]) {
+	const [major, minor, sub = 0] = pld.split('.').map(Number);
+	const mb = Number(sdram);
+	const size = { 8: 0, 16: 1, 32: 2 }[mb] ?? 3;
+	if (size === 3 && (mb < 64 || mb > 512 || mb % 64)) throw new Error(`Unsupported SDRAM size: ${mb} MB`);
+	const sizeAux = size === 3 ? mb / 64 - 1 : 0;
+
+	ports.set(73, (ports.get(73) & ~0x3c) | ((Number(type) & 0x0f) << 2));
+	ports.set(78, major * 10 + minor);
+	ports.set(79, (ports.get(79) & 0x80) | ((sub & 0x03) << 5) | (Number(iorev) & 0x1f));
+	ports.set(0, (ports.get(0) & ~0x18) | (size << 3));
+	ports.set(1, (ports.get(1) & ~0x0e) | (sizeAux << 1));
+	for (const override of overrides) {
+		const [port, value] = override.split('=');
+		ports.set(parseNumber(port), parseNumber(value));
+	}
+}
+
+const tcl = fs.readFileSync(inputTclPath, 'utf8');
+
+// Initial port values, then the machine preset
+const ports = new Map();
+const portTokens = arrayBlock(tcl, 'ioports_array').trim().split(/\s+/);
+for (let i = 0; i + 1 < portTokens.length; i += 2) {
+	ports.set(parseNumber(portTokens[i]), parseNumber(portTokens[i + 1]));
+}
+const machines = readMachines(machinesPath);
+const machine = machineName || machines.keys().next().value;
+if (!machines.has(machine)) throw new Error(`Unknown OCM machine preset: ${machine}`);
+applyMachine(ports, machines.get(machine));
+
+// Smart commands: N { port mask value ... }
+const commands = [];
+for (const match of arrayBlock(tcl, 'cmd').matchAll(/(\d+)\s*\{([^}]*)\}/g)) {
+	const values = match[2].trim().split(/\s+/).map(parseNumber);
+	const effects = [];
+	for (let i = 0; i + 2 < values.length; i += 3) {
+		if (values[i + 1]) effects.push(values.slice(i, i + 3));
+	}
+	commands.push({ cmd: parseNumber(match[1]), effects });
+}
+const maxEffects = Math.max(1, ...commands.map(command => command.effects.length));
+
+const hex = value => '0x' + value.toString(16).padStart(2, '0');
+let out = `// Generated by bin/parse_ioports.js from emulation/ocm_ioports.tcl (machine: ${machine}). Do not edit.
+#pragma once
+#include <stdint.h>
+
+#define OCM_CMD_EFFECTS\t${maxEffects}
+
+typedef struct {
+\tuint8_t port;
+\tuint8_t mask;
+\tuint8_t value;
+} OcmEffect_t;
+
+typedef struct {
+\tuint8_t cmd;
+\tuint8_t count;
+\tOcmEffect_t effects[OCM_CMD_EFFECTS];
+} OcmCommand_t;
+
+static const uint8_t ocm_initialPorts[][2] = {
+`;
+for (const [port, value] of [...ports].sort((a, b) => a[0] - b[0])) {
+	out += `\t{ ${String(port).padStart(3)}, ${hex(value)} },\n`;
+}
+out += `};
+
+static const OcmCommand_t ocm_commands[] = {
+`;
+for (const command of commands) {
+	const effects = command.effects.map(([port, mask, value]) => `{ ${port}, ${hex(mask)}, ${hex(value)} }`).join(', ') || '{ 0 }';
+	out += `\t{ ${String(command.cmd).padStart(3)}, ${command.effects.length}, { ${effects} } },\n`;
+}
+out += '};\n';
+
+fs.mkdirSync(path.dirname(outputHPath), { recursive: true });
+fs.writeFileSync(outputHPath, out);
@@ -0,0 +1,215 @@
+#!/usr/bin/nodejs
+const fs = require('fs');
+const path = require('path');
+
+const inputIniPath = path.join(__dirname, '..', 'res', 'panels.ini');
+const stringsIniPath = path.join(__dirname, '..', 'res', 'strings.ini');
+const outputHPath = path.join(__dirname, '..', 'res/out', 'panels_data.h');
+
+const TEXT_WIDTH = 80;			// Screen 0 width 80: name table at VRAM 0x0000
+const MAX_DESC = 3;				// ELEMENT_MAX_DESC
+
+/**
+ * Reads an INI file as a list of sections with their keys, in file order.
+ * Comments (';') and empty lines are ignored.
+ * @param {string} file The INI file path.
+ * @returns {Array<{name: string, keys: Map<string, string>}>} The sections.
+ */
+function readIni(file) {
+	const sections = [];
+	let current = null;
+	const lines = fs.readFileSync(file, 'utf-8').split(/\r?\n/);
+	for (const line of lines) {
+		const trimmedLine = line.trim();
+		if (trimmedLine.startsWith(';') || trimmedLine === '') continue;
+		if (trimmedLine.startsWith('[')) {
+			current = { name: trimmedLine.substring(1, trimmedLine.indexOf(']')).trim(), keys: new Map() };
+			sections.push(current);
+			continue;
+		}
+		const separatorIndex = trimmedLine.indexOf('=');
+		if (separatorIndex === -1 || !current) {
+			console.warn(`Skipping invalid line: ${line}`);
+			continue;
+		}
+		current.keys.set(trimmedLine.substring(0, separatorIndex).trim(), trimmedLine.substring(separatorIndex + 1).trim());
+	}
+	return sections;
+}
+
+/**
+ * Gets the length in bytes of each string of strings.ini (after the escape
+ * sequences are interpreted, as parse_strings.js does).
+ * @returns {Map<string, number>} Lengths by key.
+ */
+function readStringLengths() {
+	const lengths = new Map();
+	const lines = fs.readFileSync(stringsIniPath, 'utf-8').split(/\r?\n/);
+	for (const line of lines) {
+		const trimmedLine = line.trim();
+		if (trimmedLine.startsWith(';') || trimmedLine === '' || trimmedLine.startsWith('[')) continue;
+		const separatorIndex = trimmedLine.indexOf('=');
+		if (separatorIndex === -1) continue;
+		let value = trimmedLine.substring(separatorIndex + 1).trim();
+		const commentIndex = value.lastIndexOf(';');
+		if (commentIndex !== -1 && commentIndex > value.lastIndexOf('"')) {
+			value = value.substring(0, commentIndex).trim();
+		}
+		if (value.startsWith('"') && value.endsWith('"')) {
+			value = value.substring(1, value.length - 1);
+		}
+		value = value.replace(/\\x[0-9A-Fa-f]{2}|\\./g, 'x');
+		lengths.set(trimmedLine.substring(0, separatorIndex).trim(), value.length);
+	}
+	return lengths;
+}
+
+/**
+ * Splits a comma separated list, trimming the items.
+ */
+function splitList(value) {
+	return value ? value.split(',').map(item => item.trim()).filter(item => item !== '') : [];
+}
+
+/**
+ * Number of trailing zero bits of a mask (0 for an empty mask).
+ */
+function maskShift(mask) {
+	let value = Number(mask), shift = 0;
+	if (!value) return 0;
+	while (!(value & 1)) {
+		value >>= 1;
+		shift++;
+	}
+	return shift;
+}
+
+try {
+	console.log(`Reading INI file: ${inputIniPath}`);
+	const sections = readIni(inputIniPath);
+	const stringLengths = readStringLengths();
+
+	// Group elements by panel keeping the file order
+	const panels = new Map();	// Map<panelName, element[]>
+	for (const section of sections) {
+		const dot = section.name.indexOf('.');
+		if (dot === -1) throw new Error(`Invalid element section name [${section.name}]`);
+		const panel = section.name.substring(0, dot);
+		if (!panels.has(panel)) panels.set(panel, []);
+		panels.get(panel).push({ id: section.name.substring(dot + 1), keys: section.keys });
+	}
+
+	let hContent = `// File generated by bin/parse_panels.js script
+// DO NOT EDIT MANUALLY
+
+#ifndef PANELS_DATA_H_
+#define PANELS_DATA_H_
+
+`;
+	let indexes = '';
+	let tables = '';
+	let maxElements = 0;
+	const cmdArrays = new Map();	// Map<cmdsList, arrayName>
+
+	for (const [panel, elements] of panels) {
+		const ids = elements.map(element => element.id);
+		maxElements = Math.max(maxElements, elements.length);
+		let cmds = '', hot = '', cold = '', labels = '';
+
+		console.log(`Processing panel ${panel}: ${elements.length} elements...`);
+		elements.forEach((element, index) => {
+			const get = (key, defValue) => element.keys.has(key) ? element.keys.get(key) : defValue;
+			const where = `[${panel}.${element.id}]`;
+
+			// Index define
+			indexes += `#define ELEM_${panel.toUpperCase()}_${element.id} ${index}\n`;
+
+			// Position & label
+			const [posX, posY] = splitList(get('pos', '')).map(Number);
+			if (!posX || !posY) throw new Error(`${where} Invalid pos`);
+			const label = get('label', '');
+			if (label && !stringLengths.has(label)) throw new Error(`${where} Unknown label ${label}`);
+			const labelLen = label ? stringLengths.get(label) : 0;
+			if (labelLen) {
+				const vram = (posY - 1) * TEXT_WIDTH + (posX - 1);
+				labels += `\t{ 0x${vram.toString(16).padStart(4, '0')}, ${label}, ${labelLen} },\n`;
+			}
+
+			// Navigation: relative offsets to the target elements
+			const nav = ['up', 'down', 'left', 'right'].map(key => {
+				const target = get(key, null);
+				if (target === null) return 0;
+				const targetIndex = ids.indexOf(target);
+				if (targetIndex === -1) throw new Error(`${where} Unknown ${key} element ${target}`);
+				return targetIndex - index;
+			});
+
+			// Value
+			const mask = get('mask', '0');
+			const [minValue, maxValue] = splitList(get('range', '0,0')).map(Number);
+			const valueX = posX + Number(get('valueX', '0'));
+
+			// Commands
+			const cmdType = get('cmdType', 'CMDTYPE_NONE');
+			const cmdList = splitList(get('cmds', ''));
+			let cmdName = 'NULL';
+			if (cmdList.length) {
+				if (cmdType === 'CMDTYPE_STANDARD' && cmdList.length < maxValue + 1) {
+					throw new Error(`${where} ${cmdList.length} cmds for range ${minValue},${maxValue}`);
+				}
+				const cmdKey = cmdList.join(', ');
+				if (!cmdArrays.has(cmdKey)) {
+					cmdArrays.set(cmdKey, `cmd${panel}_${element.id}`);
+					cmds += `static const uint8_t cmd${panel}_${element.id}[] = { ${cmdKey} };\n`;
+				}
+				cmdName = cmdArrays.get(cmdKey);
+			}
+
+			// Description
+			const desc = splitList(get('desc', ''));
+			if (desc.length > MAX_DESC) throw new Error(`${where} Too many desc lines`);
+			if (desc.length && desc.length < MAX_DESC) desc.push('ARRAYEND');
+
+			hot += `\t{ ${get('type', 'LABEL')}, ${posX},${posY}, ${nav.join(',')}, ` +
+				`${get('value', 'NULL')}, ${mask},${maskShift(mask)}, ${minValue},${maxValue}, ${valueX}, ` +
+				`${cmdType}, ${get('attribs', '0')} },\t// ${element.id}\n`;
+			cold += `\t{ ${labelLen}, ${get('values', 'NULL')}, ${cmdName}, { ${desc.length ? desc.join(', ') : '0'} }, ` +
+				`${get('iorev', 'IOREV_ALL')}, ${get('machines', 'M_ALL')} },\t// ${element.id}\n`;
+		});
+
+		tables += `
+// ========================================================
+// Panel ${panel}
+
+${cmds}${cmds ? '\n' : ''}static const Element_t elem${panel}[] = {
+${hot}\t{ END }
+};
+
+static const ElementInfo_t elem${panel}Info[] = {
+${cold}\t{ 0 }
+};
+
+static const PanelLabel_t elem${panel}Labels[] = {
+${labels}\t{ 0 }
+};
+
+static uint8_t elem${panel}Avail[${(elements.length >> 3) + 1}];
+`;
+	}
+
+	hContent += `#define PANELS_MAX_ELEMENTS ${maxElements}
+
+// Elements indexes
+
+${indexes}${tables}
+#endif /* PANELS_DATA_H_ */
+`;
+
+	console.log(`Generating header file: ${outputHPath}`);
+	fs.writeFileSync(outputHPath, hContent, 'utf-8');
+	console.log('Done.');
+
+} catch (error) {
+	console.error('Error processing panels:', error);
+	process.exit(1);
+}
@@ -0,0 +1,308 @@
+# Headless benchmark of the OCMINFO hot paths (used by 'make bench')
+#
+# Environment:
+#   BENCH_CSV   Output CSV file (default: bench.csv)
+#   BENCH_NOI   NoICE symbols file of the program, to locate _kbhit
+#   BENCH_SCREENS  Directory where the text screens are dumped (default: none)
+#
+# Each scenario injects keys into the BIOS key buffer while the program waits
+# at kbhit(), and measures the emulated time until it waits for keys again.
+# Times are reported in microseconds, in cycles of the standard 3.58MHz
+# clock (cycles358: not the T-states run on R800 or turbo modes), and in
+# NTSC frames.
+#
+# With BENCH_SCREENS, the screen at the end of each scenario and at each
+# 'screen' action is written as NAME.bin: VDP registers 0-13, followed by
+# the TEXT2 name table (80x27) and blink table (10x27) from VRAM.
+#
+# Other scripts (i.e. profile.tcl) can follow the run with add_hook:
+#   begin NAME / end NAME   A scenario starts or ends
+#   finish                  The run ends, before openMSX exits
+
+namespace eval bench {
+
+	variable z80_clock 3579545
+	variable frame_rate 59.94
+	variable boot_time 12
+	variable timeout 600
+
+	# BIOS key buffer
+	variable KEYBUF		0xfbf0
+	variable KEYBUF_END	0xfc18
+	variable PUTPNT		0xf3f8
+	variable GETPNT		0xf3fa
+
+	variable csv_file "bench.csv"
+	variable screens_dir ""
+	variable kbhit_addr
+	variable mode none
+	variable results {}
+	variable current ""
+	variable steps 0
+	variable start_time 0
+	variable hooks {}
+
+	# Actions:
+	#   run CMD       Type a DOS command and wait for the program entry
+	#   begin NAME    Start measuring a scenario
+	#   keys CODES    Inject the keys and wait until the program is idle again
+	#   wait_idle     Wait until the program is idle
+	#   wait_exit     Wait until the program returns to DOS
+	#   end           Record the measured scenario
+	#   screen NAME   Dump the current screen
+	variable actions {}
+
+	proc codes {text} {
+		set result {}
+		foreach char [split $text ""] {
+			lappend result [scan $char %c]
+		}
+		return $result
+	}
+
+	proc build_actions {} {
+		variable actions
+		set ENTER 13
+		set ESC 27
+
+		set actions [list \
+			{run "OCMINFO"} \
+			{begin startup} {wait_idle} {end} \
+			\
+			{begin panels_f1_f5} \
+				[list keys {*}[codes "1"]] {screen panel1} [list keys {*}[codes "2"]] {screen panel2} \
+				[list keys {*}[codes "3"]] {screen panel3} [list keys {*}[codes "4"]] {screen panel4} \
+				[list keys {*}[codes "5"]] {screen panel5} \
+			{end} \
+			\
+			[list keys {*}[codes "1"]] \
+			{begin slider_sweep} \
+		]
+		for {set i 0} {$i < 8} {incr i} { lappend actions [list keys {*}[codes "+"]] }
+		for {set i 0} {$i < 8} {incr i} { lappend actions [list keys {*}[codes "-"]] }
+		lappend actions {end}
+
+		# The bench disk has no profiles file: confirm its creation
+		lappend actions {begin profiles_open} [list keys {*}[codes "P"]] [list keys $ENTER] {end}
+		lappend actions [list keys {*}[codes "ABENCH"] $ENTER]
+		lappend actions {begin profile_apply} [list keys $ENTER] [list keys $ENTER] {end}
+
+		# Save profiles & quit
+		lappend actions [list keys {*}[codes "B"]] [list keys $ENTER]
+		lappend actions [list keys $ESC] [list keys $ENTER] {wait_exit}
+
+		lappend actions {run "OCMINFO /1"} {begin cli_apply} {wait_exit} {end}
+	}
+
+	proc add_hook {event script} {
+		variable hooks
+		lappend hooks $event $script
+	}
+
+	proc run_hooks {event args} {
+		variable hooks
+		foreach {name script} $hooks {
+			if {$name eq $event} { uplevel #0 $script $args }
+		}
+	}
+
+	proc peek_word {addr} {
+		return [expr {[peek $addr] | ([peek [expr {$addr + 1}]] << 8)}]
+	}
+
+	proc poke_word {addr value} {
+		poke $addr [expr {$value & 0xff}]
+		poke [expr {$addr + 1}] [expr {$value >> 8}]
+	}
+
+	proc key_buffer_empty {} {
+		variable PUTPNT
+		variable GETPNT
+		return [expr {[peek_word $PUTPNT] == [peek_word $GETPNT]}]
+	}
+
+	proc inject_keys {keys} {
+		variable KEYBUF
+		variable KEYBUF_END
+		variable PUTPNT
+
+		set put [peek_word $PUTPNT]
+		foreach code $keys {
+			poke $put $code
+			incr put
+			if {$put >= $KEYBUF_END} { set put $KEYBUF }
+		}
+		poke_word $PUTPNT $put
+	}
+
+	proc find_symbol {file name} {
+		set addr ""
+		set fh [open $file r]
+		while {[gets $fh line] >= 0} {
+			if {[lindex $line 0] eq "DEF" && [lindex $line 1] eq $name} {
+				set addr [lindex $line 2]
+				break
+			}
+		}
+		close $fh
+		return $addr
+	}
+
+	proc next_action {} {
+		variable actions
+		variable mode
+		variable current
+		variable steps
+		variable start_time
+
+		set mode none
+		while {[llength $actions]} {
+			set action [lindex $actions 0]
+			set actions [lrange $actions 1 end]
+			switch -- [lindex $action 0] {
+				run {
+					type "[lindex $action 1]\r"
+					set mode entry
+					return
+				}
+				begin {
+					set current [lindex $action 1]
+					set steps 0
+					set start_time [machine_info time]
+					run_hooks begin $current
+				}
+				keys {
+					inject_keys [lrange $action 1 end]
+					incr steps
+					set mode idle
+					return
+				}
+				wait_idle {
+					set mode idle
+					return
+				}
+				wait_exit {
+					set mode exit
+					return
+				}
+				end {
+					record
+				}
+				screen {
+					dump_screen [lindex $action 1]
+				}
+			}
+		}
+		finish 0
+	}
+
+	proc record {} {
+		variable results
+		variable current
+		variable steps
+		variable start_time
+		variable z80_clock
+		variable frame_rate
+
+		set elapsed [expr {[machine_info time] - $start_time}]
+		run_hooks end $current
+		dump_screen $current
+		lappend results [list $current $steps \
+			[expr {round($elapsed * 1000000)}] \
+			[expr {round($elapsed * $z80_clock)}] \
+			[format %.2f [expr {$elapsed * $frame_rate}]]]
+		set current ""
+	}
+
+	proc dump_screen {name} {
+		variable screens_dir
+		if {$screens_dir eq ""} return
+
+		set regs ""
+		for {set r 0} {$r < 14} {incr r} {
+			append regs [binary format c [vdpreg $r]]
+		}
+		set names [expr {([vdpreg 2] & 0x7c) << 10}]
+		set blink [expr {(([vdpreg 10] & 0x07) << 14) | (([vdpreg 3] & 0xf8) << 6)}]
+		set fh [open [file join $screens_dir $name.bin] w]
+		fconfigure $fh -translation binary
+		puts -nonewline $fh $regs
+		puts -nonewline $fh [debug read_block VRAM $names 2160]
+		puts -nonewline $fh [debug read_block VRAM $blink 270]
+		close $fh
+	}
+
+	proc finish {code} {
+		variable csv_file
+		variable results
+
+		run_hooks finish
+		set fh [open $csv_file w]
+		puts $fh "scenario,steps,usecs,cycles358,frames"
+		foreach row $results {
+			puts $fh [join $row ","]
+		}
+		close $fh
+		exit $code
+	}
+
+	# Breakpoint callbacks
+	proc on_idle {} {
+		variable mode
+		if {$mode eq "idle"} { next_action }
+	}
+
+	proc on_entry {} {
+		variable mode
+		if {$mode eq "entry"} { next_action }
+	}
+
+	proc on_exit {} {
+		variable mode
+		if {$mode eq "exit"} { next_action }
+	}
+
+	proc on_timeout {} {
+		variable current
+		puts stderr "bench: timeout waiting for scenario '$current'"
+		finish 1
+	}
+
+	proc bench_start {} {
+		variable csv_file
+		variable screens_dir
+		variable kbhit_addr
+		variable boot_time
+		variable timeout
+
+		if {[info exists ::env(BENCH_CSV)]} { set csv_file $::env(BENCH_CSV) }
+		if {[info exists ::env(BENCH_SCREENS)]} {
+			set screens_dir $::env(BENCH_SCREENS)
+			file mkdir $screens_dir
+		}
+		set noi "obj/ocminfo.noi"
+		if {[info exists ::env(BENCH_NOI)]} { set noi $::env(BENCH_NOI) }
+		set kbhit_addr [find_symbol $noi "_kbhit"]
+		if {$kbhit_addr eq ""} {
+			puts stderr "bench: _kbhit not found in $noi"
+			exit 1
+		}
+
+		set ::renderer none
+		set ::throttle off
+		set ::mute on
+
+		build_actions
+		add_hook begin ocm_trace_mark
+		debug set_bp $kbhit_addr {[bench::key_buffer_empty]} {bench::on_idle}
+		debug set_bp 0x0100 {} {bench::on_entry}
+		debug set_bp 0x0005 {[reg C] == 0x62 || [reg C] == 0x00} {bench::on_exit}
+		debug set_bp 0x0000 {} {bench::on_exit}
+
+		after time $boot_time bench::next_action
+		after time $timeout bench::on_timeout
+	}
+
+} ; #namespace
+
+bench::bench_start
@@ -0,0 +1,1250 @@
+/*
+	Copyright (c) 2024 Natalia Pujol Cremades
+	info@abitwitches.com
+
+	See LICENSE file.
+*/
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <time.h>
+#include "msx.h"
+#include "ocm_ioports_table.h"
+
+
+// ========================================================
+// Defines
+
+// System area
+#define BDOS		0x0005
+#define RDSLT		0x000c
+#define WRSLT		0x0014
+#define CALSLT		0x001c
+#define ENASLT		0x0024
+#define CALLF		0x0030
+#define KEYINT		0x0038
+#define TRAP_LIMIT	0x0040
+
+#define MSXVER		0x002d
+#define LINL40		0xf3ae
+#define LINLEN		0xf3b0
+#define CRTCNT		0xf3b1
+#define CSRY		0xf3dc
+#define CSRX		0xf3dd
+#define RG0SAV		0xf3df
+#define FORCLR		0xf3e9
+#define BAKCLR		0xf3ea
+#define BDRCLR		0xf3eb
+#define PUTPNT		0xf3f8
+#define GETPNT		0xf3fa
+#define EXBRSA		0xfaf8
+#define HOKVLD		0xfb20
+#define NEWKEY		0xfbe5
+#define KEYBUF		0xfbf0
+#define KEYBUF_END	0xfc18
+#define JIFFY		0xfc9e
+#define SCRMOD		0xfcaf
+#define OLDSCR		0xfcb0
+#define EXPTBL		0xfcc1
+#define H_TIMI		0xfd9f
+#define HOOKS		0xfd9a
+#define EXTBIO		0xffca
+#define RG8SAV		0xffe7
+
+// MSX-DOS errors
+#define ERR_EOF		0xc7
+#define ERR_NOPEN	0xc2
+#define ERR_IHAND	0xc3
+#define ERR_NHAND	0xc4
+#define ERR_DUPF	0xca
+#define ERR_FILEX	0xcb
+#define ERR_ELONG	0xbf
+#define ERR_NOFIL	0xd7
+#define ERR_IPATH	0xd9
+#define ERR_IFNM	0xda
+#define ERR_IDRV	0xdb
+#define ERR_IBDOS	0xdc
+#define ERR_WRERR	0xfe
+
+#define FIRST_HANDLE	5				// 0-4 are the standard console/aux/printer handles
+
+#define REPORT_BIOS		0x10000
+#define REPORT_SUBROM	0x20000
+#define REPORT_DOS		0x30000
+#define REPORT_HOOK		0x40000
+
+#define REG_A(m)	(m)->cpu.af.b.h
+#define REG_F(m)	(m)->cpu.af.b.l
+#define REG_B(m)	(m)->cpu.bc.b.h
+#define REG_C(m)	(m)->cpu.bc.b.l
+#define REG_D(m)	(m)->cpu.de.b.h
+#define REG_E(m)	(m)->cpu.de.b.l
+#define REG_H(m)	(m)->cpu.hl.b.h
+#define REG_L(m)	(m)->cpu.hl.b.l
+#define REG_BC(m)	(m)->cpu.bc.w
+#define REG_DE(m)	(m)->cpu.de.w
+#define REG_HL(m)	(m)->cpu.hl.w
+#define REG_IX(m)	(m)->cpu.ix.w
+
+
+// ========================================================
+// Helpers
+
+static uint16_t peek16(Msx_t *msx, uint16_t addr)
+{
+	return msx->mem[addr] | (msx->mem[(uint16_t)(addr + 1)] << 8);
+}
+
+static void poke16(Msx_t *msx, uint16_t addr, uint16_t value)
+{
+	msx->mem[addr] = value & 0xff;
+	msx->mem[(uint16_t)(addr + 1)] = value >> 8;
+}
+
+static void reportUnsupported(Msx_t *msx, uint32_t kind, uint16_t value)
+{
+	static const char *names[] = { "", "BIOS call", "SUBROM call", "MSX-DOS function", "hook" };
+	uint32_t key = kind | value;
+
+	for (uint8_t i = 0; i < msx->reportedCount; i++) {
+		if (msx->reported[i] == key) return;
+	}
+	if (msx->reportedCount < sizeof(msx->reported) / sizeof(msx->reported[0])) {
+		msx->reported[msx->reportedCount++] = key;
+	}
+	fprintf(stderr, "harness: unsupported %s 0x%04X (PC=0x%04X)\n", names[kind >> 16], value,
+		peek16(msx, msx->cpu.sp.w));
+}
+
+static bool readString(Msx_t *msx, uint16_t addr, char *buffer, size_t size)
+{
+	size_t i;
+	for (i = 0; i < size - 1 && msx->mem[(uint16_t)(addr + i)]; i++) {
+		buffer[i] = msx->mem[(uint16_t)(addr + i)];
+	}
+	buffer[i] = '\0';
+	return i < size - 1;
+}
+
+static void writeString(Msx_t *msx, uint16_t addr, const char *text)
+{
+	do {
+		msx->mem[addr++] = *text;
+	} while (*text++);
+}
+
+
+// ========================================================
+// VDP
+
+static inline void vramWrite(Msx_t *msx, uint32_t addr, uint8_t value)
+{
+	msx->vram[addr & 0x1ffff] = value;
+}
+
+static inline uint8_t vramRead(Msx_t *msx, uint32_t addr)
+{
+	return msx->vram[addr & 0x1ffff];
+}
+
+static bool isText2(Msx_t *msx)
+{
+	return (msx->vdpReg[1] & 0x18) == 0x10 && (msx->vdpReg[0] & 0x0e) == 0x04;
+}
+
+static uint8_t screenWidth(Msx_t *msx)
+{
+	return isText2(msx) ? 80 : 40;
+}
+
+static uint8_t screenHeight(Msx_t *msx)
+{
+	return (msx->vdpReg[9] & 0x80) ? 27 : 24;
+}
+
+static uint32_t nameTable(Msx_t *msx)
+{
+	if (isText2(msx)) return (msx->vdpReg[2] & 0x7c) << 10;
+	return (msx->vdpReg[2] & 0x7f) << 10;
+}
+
+static uint32_t blinkTable(Msx_t *msx)
+{
+	return ((msx->vdpReg[10] & 0x07) << 14) | ((msx->vdpReg[3] & 0xf8) << 6);
+}
+
+static void vdpSetRegister(Msx_t *msx, uint8_t reg, uint8_t value)
+{
+	if (reg >= sizeof(msx->vdpReg)) return;
+	msx->vdpReg[reg] = value;
+}
+
+static void vdpOut(Msx_t *msx, uint8_t port, uint8_t value)
+{
+	switch (port) {
+		case 0x98:
+			msx->vdpLatchFull = false;
+			vramWrite(msx, msx->vramAddr, value);
+			msx->vdpReadAhead = value;
+			msx->vramAddr = (msx->vramAddr + 1) & 0x1ffff;
+			break;
+		case 0x99:
+			if (!msx->vdpLatchFull) {
+				msx->vdpLatch = value;
+				msx->vdpLatchFull = true;
+				break;
+			}
+			msx->vdpLatchFull = false;
+			if (value & 0x80) {
+				vdpSetRegister(msx, value & 0x3f, msx->vdpLatch);
+			} else {
+				msx->vramAddr = ((msx->vdpReg[14] & 0x07) << 14) | ((value & 0x3f) << 8) | msx->vdpLatch;
+				if (!(value & 0x40)) {
+					msx->vdpReadAhead = vramRead(msx, msx->vramAddr);
+					msx->vramAddr = (msx->vramAddr + 1) & 0x1ffff;
+				}
+			}
+			break;
+		case 0x9b:
+			vdpSetRegister(msx, msx->vdpReg[17] & 0x3f, value);
+			if (!(msx->vdpReg[17] & 0x80)) msx->vdpReg[17] = (msx->vdpReg[17] & 0x80) | ((msx->vdpReg[17] + 1) & 0x3f);
+			break;
+	}
+}
+
+static uint8_t vdpIn(Msx_t *msx, uint8_t port)
+{
+	uint8_t value;
+	uint32_t frameTime, lineTime;
+
+	msx->vdpLatchFull = false;
+	if (port == 0x98) {
+		value = msx->vdpReadAhead;
+		msx->vdpReadAhead = vramRead(msx, msx->vramAddr);
+		msx->vramAddr = (msx->vramAddr + 1) & 0x1ffff;
+		return value;
+	}
+	if (port != 0x99) return 0xff;
+
+	switch (msx->vdpReg[15] & 0x0f) {
+		case 0:
+			value = msx->vdpStatus[0];
+			msx->vdpStatus[0] &= 0x7f;
+			msx->irqPending = false;
+			return value;
+		case 1:
+			return msx->mem[MSXVER] >= 2 ? 0x04 : 0x00;		// V9958 / V9938 ID
+		case 2:
+			frameTime = msx->cpu.tstates % MSX_FRAME_TSTATES;
+			lineTime = msx->cpu.tstates % 228;
+			return 0x8c | (frameTime >= 228 * 192 ? 0x40 : 0) | (lineTime >= 180 ? 0x20 : 0);
+		default:
+			return msx->vdpStatus[msx->vdpReg[15] & 0x0f];
+	}
+}
+
+static void setTextMode(Msx_t *msx)
+{
+	static const uint8_t text1[] = { 0x00, 0x70, 0x00, 0x00, 0x01 };
+	static const uint8_t text2[] = { 0x04, 0x70, 0x03, 0x27, 0x02 };
+	bool wide = msx->mem[LINL40] > 40;
+	const uint8_t *regs = wide ? text2 : text1;
+
+	for (uint8_t reg = 0; reg < 5; reg++) vdpSetRegister(msx, reg, regs[reg]);
+	vdpSetRegister(msx, 7, (msx->mem[FORCLR] << 4) | (msx->mem[BAKCLR] & 0x0f));
+	vdpSetRegister(msx, 10, 0);
+	vdpSetRegister(msx, 14, 0);
+	for (uint8_t reg = 0; reg < 8; reg++) msx->mem[RG0SAV + reg] = msx->vdpReg[reg];
+
+	memset(msx->vram + nameTable(msx), ' ', 2160);
+	memset(msx->vram + blinkTable(msx), 0, 270);
+	msx->mem[SCRMOD] = 0;
+	msx->mem[LINLEN] = msx->mem[LINL40];
+	msx->mem[CSRX] = msx->mem[CSRY] = 1;
+}
+
+
+// ========================================================
+// Console
+
+static void clearScreen(Msx_t *msx)
+{
+	memset(msx->vram + nameTable(msx), ' ', screenWidth(msx) * screenHeight(msx));
+	msx->mem[CSRX] = msx->mem[CSRY] = 1;
+}
+
+static void scrollUp(Msx_t *msx)
+{
+	uint8_t width = screenWidth(msx);
+	uint8_t *base = msx->vram + nameTable(msx);
+	uint8_t lines = msx->mem[CRTCNT] ? msx->mem[CRTCNT] : 24;
+
+	memmove(base, base + width, width * (lines - 1));
+	memset(base + width * (lines - 1), ' ', width);
+}
+
+static void newLine(Msx_t *msx)
+{
+	uint8_t lines = msx->mem[CRTCNT] ? msx->mem[CRTCNT] : 24;
+	if (msx->mem[CSRY] >= lines) scrollUp(msx);
+	else msx->mem[CSRY]++;
+}
+
+// CHPUT & MSX-DOS console output: control codes and VT-52 escapes
+static void consoleOut(Msx_t *msx, uint8_t ch)
+{
+	uint8_t width = msx->mem[LINLEN] ? msx->mem[LINLEN] : screenWidth(msx);
+	uint8_t *x = &msx->mem[CSRX], *y = &msx->mem[CSRY];
+
+	if (msx->console) fputc(ch == '\r' ? '\n' : ch, msx->console);
+	if (ch == '\n' && msx->console) fflush(msx->console);
+
+	switch (msx->escState) {
+		case 1:
+			msx->escState = 0;
+			switch (ch) {
+				case 'Y': msx->escState = 2; return;
+				case 'x': case 'y': msx->escState = 4; return;
+				case 'E': case 'j': clearScreen(msx); return;
+				case 'H': *x = *y = 1; return;
+				case 'K':
+					memset(msx->vram + nameTable(msx) + (*y - 1) * screenWidth(msx) + *x - 1, ' ', width - *x + 1);
+					return;
+				case 'J':
+					memset(msx->vram + nameTable(msx) + (*y - 1) * screenWidth(msx) + *x - 1, ' ',
+						screenWidth(msx) * screenHeight(msx) - ((*y - 1) * screenWidth(msx) + *x - 1));
+					return;
+				case 'A': if (*y > 1) (*y)--; return;
+				case 'B': newLine(msx); return;
+				case 'C': if (*x < width) (*x)++; return;
+				case 'D': if (*x > 1) (*x)--; return;
+				case 'l':
+					memset(msx->vram + nameTable(msx) + (*y - 1) * screenWidth(msx), ' ', width);
+					return;
+				default: return;
+			}
+		case 2:
+			msx->escRow = ch - 31;
+			msx->escState = 3;
+			return;
+		case 3:
+			*y = msx->escRow;
+			*x = ch - 31;
+			msx->escState = 0;
+			return;
+		case 4:
+			msx->escState = 0;
+			return;
+	}
+
+	switch (ch) {
+		case 0x07: return;
+		case 0x08: case 0x1d: if (*x > 1) (*x)--; return;
+		case 0x09: do { consoleOut(msx, ' '); } while ((*x - 1) & 7); return;
+		case 0x0a: newLine(msx); return;
+		case 0x0b: *x = *y = 1; return;
+		case 0x0c: clearScreen(msx); return;
+		case 0x0d: *x = 1; return;
+		case 0x1b: msx->escState = 1; return;
+		case 0x1c: if (*x < width) (*x)++; return;
+		case 0x1e: if (*y > 1) (*y)--; return;
+		case 0x1f: newLine(msx); return;
+	}
+	if (ch < 0x20) return;
+
+	vramWrite(msx, nameTable(msx) + (*y - 1) * screenWidth(msx) + *x - 1, ch);
+	if (++(*x) > width) {
+		*x = 1;
+		newLine(msx);
+	}
+}
+
+
+// ========================================================
+// Keyboard buffer
+
+bool msx_keyBufferEmpty(Msx_t *msx)
+{
+	return peek16(msx, PUTPNT) == peek16(msx, GETPNT);
+}
+
+bool msx_pushKeys(Msx_t *msx, const uint8_t *keys, uint16_t count)
+{
+	uint16_t put = peek16(msx, PUTPNT);
+
+	while (count--) {
+		uint16_t next = put + 1 >= KEYBUF_END ? KEYBUF : put + 1;
+		if (next == peek16(msx, GETPNT)) return false;
+		msx->mem[put] = *keys++;
+		put = next;
+	}
+	poke16(msx, PUTPNT, put);
+	return true;
+}
+
+static uint8_t getKey(Msx_t *msx)
+{
+	uint16_t get = peek16(msx, GETPNT);
+	uint8_t key = msx->mem[get];
+	poke16(msx, GETPNT, get + 1 >= KEYBUF_END ? KEYBUF : get + 1);
+	return key;
+}
+
+
+// ========================================================
+// I/O ports
+
+static void ocmOut(Msx_t *msx, uint8_t port, uint8_t value)
+{
+	switch (port) {
+		case 0x40:
+			msx->ocmId = value;
+			break;
+		case 0x41:
+			for (size_t i = 0; i < sizeof(ocm_commands) / sizeof(ocm_commands[0]); i++) {
+				const OcmCommand_t *cmd = &ocm_commands[i];
+				if (cmd->cmd != value) continue;
+				msx->ocmPort41 = value;
+				for (uint8_t e = 0; e < cmd->count; e++) {
+					const OcmEffect_t *effect = &cmd->effects[e];
+					msx->ocmPorts[effect->port] = (msx->ocmPorts[effect->port] & ~effect->mask) | (effect->value & effect->mask);
+				}
+				return;
+			}
+			fprintf(stderr, "harness: invalid smart command 0x%02X\n", value);
+			break;
+		case 0x42: case 0x43: case 0x4d:
+			msx->ocmPorts[port] = 255 - value;
+			break;
+		case 0x44:
+			msx->ocmPorts[port] = 255 - value;
+			msx->ocmPort4bId = 255 - value;
+			break;
+	}
+}
+
+static uint8_t ocmIn(Msx_t *msx, uint8_t port)
+{
+	switch (port) {
+		case 0x40: return msx->ocmId == 0xd4 ? 255 - 0xd4 : 0xff;
+		case 0x41: return 255 - msx->ocmPort41;
+		case 0x44: return msx->ocmPort4bId;
+		case 0x4b: return msx->ocmPorts[msx->ocmPort4bId];
+		default: return msx->ocmPorts[port];
+	}
+}
+
+static uint8_t ioIn(void *ctx, uint16_t port16)
+{
+	Msx_t *msx = ctx;
+	uint8_t port = port16 & 0xff;
+
+	if (port >= 0x98 && port <= 0x9b) return vdpIn(msx, port);
+	if (port >= 0x40 && port <= 0x4f) return ocmIn(msx, port);
+	if (port == 0xa9) return msx->mem[NEWKEY + (msx->ppi[2] & 0x0f)];
+	if (port >= 0xa8 && port <= 0xab) return msx->ppi[port - 0xa8];
+	return 0xff;
+}
+
+static void ioOut(void *ctx, uint16_t port16, uint8_t value)
+{
+	Msx_t *msx = ctx;
+	uint8_t port = port16 & 0xff;
+
+	if (port >= 0x98 && port <= 0x9b) vdpOut(msx, port, value);
+	else if (port >= 0x40 && port <= 0x4f) ocmOut(msx, port, value);
+	else if (port >= 0xa8 && port <= 0xab) msx->ppi[port - 0xa8] = value;
+}
+
+
+// ========================================================
+// BIOS
+
+static bool biosCall(Msx_t *msx, uint16_t addr)
+{
+	uint16_t i;
+
+	switch (addr) {
+		case 0x0047:	// WRTVDP
+			vdpSetRegister(msx, REG_C(msx) & 0x3f, REG_B(msx));
+			if (REG_C(msx) < 8) msx->mem[RG0SAV + REG_C(msx)] = REG_B(msx);
+			else if (REG_C(msx) < 24) msx->mem[RG8SAV + REG_C(msx) - 8] = REG_B(msx);
+			break;
+		case 0x004a:	// RDVRM
+		case 0x0174:	// NRDVRM
+			REG_A(msx) = vramRead(msx, REG_HL(msx));
+			break;
+		case 0x004d:	// WRTVRM
+		case 0x0177:	// NWRVRM
+			vramWrite(msx, REG_HL(msx), REG_A(msx));
+			break;
+		case 0x0050:	// SETRD
+		case 0x016e:	// NSETRD
+			msx->vramAddr = REG_HL(msx);
+			msx->vdpReadAhead = vramRead(msx, msx->vramAddr++);
+			break;
+		case 0x0053:	// SETWRT
+		case 0x0171:	// NSTWRT
+			msx->vramAddr = REG_HL(msx);
+			break;
+		case 0x0056:	// FILVRM
+		case 0x016b:	// BIGFIL
+			for (i = 0; i < REG_BC(msx); i++) vramWrite(msx, REG_HL(msx) + i, REG_A(msx));
+			break;
+		case 0x0059:	// LDIRMV
+			for (i = 0; i < REG_BC(msx); i++) msx->mem[(uint16_t)(REG_DE(msx) + i)] = vramRead(msx, REG_HL(msx) + i);
+			break;
+		case 0x005c:	// LDIRVM
+			for (i = 0; i < REG_BC(msx); i++) vramWrite(msx, REG_DE(msx) + i, msx->mem[(uint16_t)(REG_HL(msx) + i)]);
+			break;
+		case 0x005f:	// CHGMOD
+			if (REG_A(msx) == 0) setTextMode(msx);
+			else msx->mem[SCRMOD] = REG_A(msx);
+			break;
+		case 0x0062:	// CHGCLR
+			vdpSetRegister(msx, 7, (msx->mem[FORCLR] << 4) | (msx->mem[BAKCLR] & 0x0f));
+			break;
+		case 0x006c:	// INITXT
+			setTextMode(msx);
+			break;
+		case 0x0090:	// GICINI
+		case 0x0093:	// WRTPSG
+		case 0x00a5:	// LPTOUT
+		case 0x00c0:	// BEEP
+		case 0x00cc:	// ERAFNK
+		case 0x00cf:	// DSPFNK
+		case 0x0180:	// CHGCPU
+			break;
+		case 0x0096:	// RDPSG
+			REG_A(msx) = 0;
+			break;
+		case 0x009c:	// CHSNS
+			if (msx_keyBufferEmpty(msx)) REG_F(msx) |= Z80_FLAG_Z;
+			else REG_F(msx) &= ~Z80_FLAG_Z;
+			break;
+		case 0x009f:	// CHGET
+			if (msx_keyBufferEmpty(msx)) return false;
+			REG_A(msx) = getKey(msx);
+			break;
+		case 0x00a2:	// CHPUT
+			consoleOut(msx, REG_A(msx));
+			break;
+		case 0x00c3:	// CLS
+			clearScreen(msx);
+			break;
+		case 0x00c6:	// POSIT
+			msx->mem[CSRX] = REG_H(msx);
+			msx->mem[CSRY] = REG_L(msx);
+			break;
+		case 0x00d5:	// GTSTCK
+		case 0x00d8:	// GTTRIG
+		case 0x0183:	// GETCPU
+			REG_A(msx) = 0;
+			break;
+		case 0x013e:	// RDVDP
+			REG_A(msx) = msx->vdpStatus[0];
+			break;
+		case 0x0141:	// SNSMAT
+			REG_A(msx) = msx->mem[NEWKEY + (REG_A(msx) & 0x0f)];
+			break;
+		case 0x0156:	// KILBUF
+			poke16(msx, GETPNT, peek16(msx, PUTPNT));
+			break;
+		case 0x015f:	// EXTROM
+			reportUnsupported(msx, REPORT_SUBROM, REG_IX(msx));
+			break;
+		default:
+			reportUnsupported(msx, REPORT_BIOS, addr);
+			break;
+	}
+	return true;
+}
+
+static bool interSlotCall(Msx_t *msx, uint8_t slot, uint16_t addr)
+{
+	if (msx->mem[EXBRSA] && slot == msx->mem[EXBRSA]) {
+		reportUnsupported(msx, REPORT_SUBROM, addr);
+		return true;
+	}
+	return biosCall(msx, addr);
+}
+
+
+// ========================================================
+// MSX-DOS files
+
+// Host path of an MSX-DOS "D:\DIR\NAME.EXT" path
+static uint8_t hostPath(Msx_t *msx, const char *msxPath, char *out)
+{
+	uint8_t drive = 0;
+	char *p;
+
+	if (msxPath[0] && msxPath[1] == ':') {
+		drive = toupper((uint8_t)msxPath[0]) - 'A';
+		msxPath += 2;
+	}
+	if (drive >= MSX_MAX_DRIVES || !msx->drives[drive][0]) return ERR_IDRV;
+	while (*msxPath == '\\' || *msxPath == '/') msxPath++;
+	if (snprintf(out, MSX_PATHLEN, "%s/%s", msx->drives[drive], msxPath) >= MSX_PATHLEN) return ERR_IPATH;
+	for (p = out + strlen(msx->drives[drive]); *p; p++) {
+		if (*p == '\\') *p = '/';
+	}
+	return 0;
+}
+
+// Expands a filename or pattern to the 11 chars FCB form ('*' becomes '?')
+static void fcbName(const char *name, char *fcb)
+{
+	uint8_t i = 0;
+
+	memset(fcb, ' ', 11);
+	while (*name && *name != '.' && i < 8) {
+		if (*name == '*') { while (i < 8) fcb[i++] = '?'; name++; break; }
+		fcb[i++] = toupper((uint8_t)*name++);
+	}
+	while (*name && *name != '.') name++;
+	if (*name == '.') name++;
+	i = 8;
+	while (*name && i < 11) {
+		if (*name == '*') { while (i < 11) fcb[i++] = '?'; break; }
+		fcb[i++] = toupper((uint8_t)*name++);
+	}
+}
+
+static bool matchName(const char *pattern, const char *name)
+{
+	char fcbPattern[11], fcbFile[11];
+	const char *dot = strchr(name, '.');
+
+	if (strlen(name) > 12 || (dot ? dot - name : (long)strlen(name)) > 8) return false;
+	if (dot && strlen(dot + 1) > 3) return false;
+	fcbName(pattern, fcbPattern);
+	fcbName(name, fcbFile);
+	for (uint8_t i = 0; i < 11; i++) {
+		if (fcbPattern[i] != '?' && fcbPattern[i] != fcbFile[i]) return false;
+	}
+	return true;
+}
+
+// Finds the host name of an existing file, ignoring case
+static bool findHostFile(const char *path, char *found)
+{
+	char dir[MSX_PATHLEN];
+	const char *name = strrchr(path, '/');
+	struct dirent *entry;
+	DIR *dp;
+	bool result = false;
+
+	snprintf(dir, sizeof(dir), "%.*s", (int)(name - path), path);
+	name++;
+	if (!(dp = opendir(dir))) return false;
+	while ((entry = readdir(dp))) {
+		if (!strcasecmp(entry->d_name, name)) {
+			snprintf(found, MSX_PATHLEN, "%s/%s", dir, entry->d_name);
+			result = true;
+			break;
+		}
+	}
+	closedir(dp);
+	return result;
+}
+
+// Fills a File Info Block from a host file
+static void fillFib(Msx_t *msx, uint16_t fib, const char *hostFile, const char *name, uint8_t drive)
+{
+	struct stat st;
+	struct tm *tm;
+	char upper[13];
+	uint8_t i;
+
+	memset(&msx->mem[fib], 0, 64);
+	msx->mem[fib] = 0xff;
+	for (i = 0; name[i] && i < 12; i++) upper[i] = toupper((uint8_t)name[i]);
+	upper[i] = '\0';
+	writeString(msx, fib + 1, upper);
+	if (stat(hostFile, &st)) return;
+	tm = localtime(&st.st_mtime);
+	msx->mem[fib + 14] = S_ISDIR(st.st_mode) ? 0x10 : 0x20;
+	poke16(msx, fib + 15, (tm->tm_hour << 11) | (tm->tm_min << 5) | (tm->tm_sec / 2));
+	poke16(msx, fib + 17, ((tm->tm_year - 80) << 9) | ((tm->tm_mon + 1) << 5) | tm->tm_mday);
+	poke16(msx, fib + 21, st.st_size & 0xffff);
+	poke16(msx, fib + 23, (st.st_size >> 16) & 0xffff);
+	msx->mem[fib + 25] = drive + 1;
+}
+
+static int compareNames(const void *a, const void *b)
+{
+	return strcmp(*(char* const*)a, *(char* const*)b);
+}
+
+// Next directory entry of the current search, in name order
+static uint8_t searchNext(Msx_t *msx)
+{
+	MsxSearch_t *search = &msx->search;
+	struct dirent *entry;
+	char *names[1024], path[MSX_PATHLEN];
+	int count = 0, i;
+	struct stat st;
+	uint8_t result = ERR_NOFIL;
+	DIR *dp;
+
+	if (!(dp = opendir(search->dir))) return ERR_NOFIL;
+	while ((entry = readdir(dp)) && count < 1024) {
+		if (entry->d_name[0] != '.' && matchName(search->pattern, entry->d_name)) {
+			names[count++] = strdup(entry->d_name);
+		}
+	}
+	closedir(dp);
+	qsort(names, count, sizeof(char*), compareNames);
+
+	for (i = search->next; i < count; i++) {
+		snprintf(path, sizeof(path), "%s/%s", search->dir, names[i]);
+		if (stat(path, &st) || (S_ISDIR(st.st_mode) && !(search->attributes & 0x10))) continue;
+		fillFib(msx, search->fib, path, names[i], 0);
+		search->next = i + 1;
+		result = 0;
+		break;
+	}
+	for (i = 0; i < count; i++) free(names[i]);
+	return result;
+}
+
+static uint8_t newHandle(Msx_t *msx)
+{
+	for (uint8_t h = FIRST_HANDLE; h < MSX_MAX_HANDLES; h++) {
+		if (!msx->handles[h].fp) return h;
+	}
+	return 0;
+}
+
+static MsxHandle_t *getHandle(Msx_t *msx, uint8_t h, uint8_t *error)
+{
+	if (h >= MSX_MAX_HANDLES) { *error = ERR_IHAND; return NULL; }
+	if (h < FIRST_HANDLE || !msx->handles[h].fp) { *error = ERR_NOPEN; return NULL; }
+	return &msx->handles[h];
+}
+
+// Host file of an ASCIIZ path or a FIB (first byte 0xFF) at DE
+static uint8_t pathArgument(Msx_t *msx, char *host)
+{
+	char msxPath[MSX_PATHLEN];
+	uint16_t de = REG_DE(msx);
+
+	if (msx->mem[de] == 0xff) {
+		readString(msx, de + 1, msxPath, 13);
+		snprintf(host, MSX_PATHLEN, "%s/%s", msx->search.dir, msxPath);
+		return 0;
+	}
+	if (!readString(msx, de, msxPath, sizeof(msxPath))) return ERR_IPATH;
+	return hostPath(msx, msxPath, host);
+}
+
+static uint8_t dosOpen(Msx_t *msx, bool create)
+{
+	char host[MSX_PATHLEN], found[MSX_PATHLEN];
+	uint8_t error, h;
+	bool exists;
+	FILE *fp;
+
+	if ((error = pathArgument(msx, host))) return error;
+	exists = findHostFile(host, found);
+	if (!create && !exists) return ERR_NOFIL;
+	if (create && exists && (REG_B(msx) & 0x80)) return ERR_FILEX;
+	if (!(h = newHandle(msx))) return ERR_NHAND;
+
+	if (create) {
+		if (exists) strcpy(host, found);
+		else for (char *p = strrchr(host, '/') + 1; *p; p++) *p = toupper((uint8_t)*p);
+		fp = fopen(host, "w+b");
+	} else {
+		strcpy(host, found);
+		fp = fopen(host, (REG_A(msx) & 0x01) ? "rb" : "r+b");
+		if (!fp) fp = fopen(host, "rb");
+	}
+	if (!fp) return create ? ERR_WRERR : ERR_NOFIL;
+
+	msx->handles[h].fp = fp;
+	strcpy(msx->handles[h].path, host);
+	REG_B(msx) = h;
+	return 0;
+}
+
+static uint8_t dosRead(Msx_t *msx, bool write)
+{
+	MsxHandle_t *handle;
+	uint16_t count = REG_HL(msx), addr = REG_DE(msx);
+	uint8_t error = 0;
+	size_t done = 0;
+
+	if (REG_B(msx) == 1 || REG_B(msx) == 2) {
+		if (!write) return ERR_EOF;
+		for (uint16_t i = 0; i < count; i++) consoleOut(msx, msx->mem[(uint16_t)(addr + i)]);
+		return 0;
+	}
+	if (!(handle = getHandle(msx, REG_B(msx), &error))) return error;
+
+	// Split the transfer if it wraps around 0xFFFF
+	while (done < count) {
+		size_t len = count - done;
+		uint16_t pos = addr + done;
+		size_t moved;
+		if (pos + len > 0x10000) len = 0x10000 - pos;
+		moved = write ? fwrite(&msx->mem[pos], 1, len, handle->fp) : fread(&msx->mem[pos], 1, len, handle->fp);
+		done += moved;
+		if (moved < len) break;
+	}
+	REG_HL(msx) = done;
+	if (write && done < count) return ERR_WRERR;
+	if (!write && !done && count) return ERR_EOF;
+	return 0;
+}
+
+static uint8_t dosSeek(Msx_t *msx)
+{
+	static const int whence[] = { SEEK_SET, SEEK_CUR, SEEK_END };
+	MsxHandle_t *handle;
+	uint8_t error = 0;
+	int32_t offset = (int32_t)(((uint32_t)REG_DE(msx) << 16) | REG_HL(msx));
+	long pos;
+
+	if (!(handle = getHandle(msx, REG_B(msx), &error))) return error;
+	if (REG_A(msx) > 2) return ERR_IBDOS;
+	fseek(handle->fp, offset, whence[REG_A(msx)]);
+	pos = ftell(handle->fp);
+	REG_DE(msx) = (pos >> 16) & 0xffff;
+	REG_HL(msx) = pos & 0xffff;
+	return 0;
+}
+
+static uint8_t dosFind(Msx_t *msx, bool first)
+{
+	MsxSearch_t *search = &msx->search;
+	char msxPath[MSX_PATHLEN], host[MSX_PATHLEN];
+	char *name;
+	uint8_t error;
+
+	if (first) {
+		if (msx->mem[REG_DE(msx)] == 0xff) {
+			readString(msx, REG_HL(msx), msxPath, sizeof(msxPath));
+			snprintf(host, sizeof(host), "%s/%s", search->dir, msxPath);
+		} else {
+			if (!readString(msx, REG_DE(msx), msxPath, sizeof(msxPath))) return ERR_IPATH;
+			if ((error = hostPath(msx, msxPath, host))) return error;
+		}
+		name = strrchr(host, '/');
+		*name++ = '\0';
+		snprintf(search->dir, sizeof(search->dir), "%s", host);
+		snprintf(search->pattern, sizeof(search->pattern), "%s", *name ? name : "*.*");
+		search->attributes = REG_B(msx);
+		search->next = 0;
+	}
+	search->fib = REG_IX(msx);
+	return searchNext(msx);
+}
+
+static uint8_t dosDelete(Msx_t *msx)
+{
+	char host[MSX_PATHLEN], found[MSX_PATHLEN];
+	uint8_t error;
+
+	if ((error = pathArgument(msx, host))) return error;
+	if (!findHostFile(host, found)) return ERR_NOFIL;
+	return remove(found) ? ERR_WRERR : 0;
+}
+
+// Renames the file at DE to the name at HL, which can't have a drive or directory
+static uint8_t dosRename(Msx_t *msx)
+{
+	char host[MSX_PATHLEN], found[MSX_PATHLEN], target[MSX_PATHLEN], existing[MSX_PATHLEN];
+	char newName[MSX_PATHLEN], upper[13];
+	uint8_t error, i;
+
+	if ((error = pathArgument(msx, host))) return error;
+	if (!readString(msx, REG_HL(msx), newName, sizeof(newName))) return ERR_IFNM;
+	if (!newName[0] || strpbrk(newName, ":\\/*?") || !matchName(newName, newName)) return ERR_IFNM;
+	if (!findHostFile(host, found)) return ERR_NOFIL;
+	for (i = 0; newName[i]; i++) upper[i] = toupper((uint8_t)newName[i]);
+	upper[i] = '\0';
+	snprintf(target, sizeof(target), "%.*s/%s", (int)(strrchr(found, '/') - found), found, upper);
+	if (findHostFile(target, existing) && strcmp(existing, found)) return ERR_DUPF;
+	return rename(found, target) ? ERR_WRERR : 0;
+}
+
+static uint8_t dosGetEnv(Msx_t *msx)
+{
+	char name[256];
+	const char *value = "";
+
+	readString(msx, REG_HL(msx), name, sizeof(name));
+	for (uint8_t i = 0; i < msx->envCount; i++) {
+		if (!strcasecmp(msx->envNames[i], name)) value = msx->envValues[i];
+	}
+	if (strlen(value) + 1 > (REG_B(msx) ? REG_B(msx) : 256)) return ERR_ELONG;
+	writeString(msx, REG_DE(msx), value);
+	return 0;
+}
+
+
+// ========================================================
+// MSX-DOS
+
+static void terminate(Msx_t *msx, uint8_t code)
+{
+	msx->exitCode = code;
+	msx->state = MSX_EXIT;
+}
+
+static bool bdos(Msx_t *msx)
+{
+	uint8_t error = 0, h;
+	uint16_t addr;
+
+	switch (REG_C(msx)) {
+		case 0x00:	// TERM0
+			terminate(msx, 0);
+			return true;
+		case 0x01:	// CONIN
+		case 0x07:	// DIRIN
+		case 0x08:	// INNOE
+			if (msx_keyBufferEmpty(msx)) return false;
+			REG_A(msx) = REG_L(msx) = getKey(msx);
+			if (REG_C(msx) == 0x01) consoleOut(msx, REG_A(msx));
+			return true;
+		case 0x02:	// CONOUT
+			consoleOut(msx, REG_E(msx));
+			return true;
+		case 0x06:	// DIRIO
+			if (REG_E(msx) != 0xff) consoleOut(msx, REG_E(msx));
+			else REG_A(msx) = REG_L(msx) = msx_keyBufferEmpty(msx) ? 0 : getKey(msx);
+			return true;
+		case 0x09:	// STROUT
+			for (addr = REG_DE(msx); msx->mem[addr] != '$'; addr++) consoleOut(msx, msx->mem[addr]);
+			return true;
+		case 0x0b:	// CONST
+			REG_A(msx) = REG_L(msx) = msx_keyBufferEmpty(msx) ? 0 : 0xff;
+			return true;
+		case 0x0c:	// CPMVER
+			REG_HL(msx) = 0x0022;
+			REG_A(msx) = 0x22;
+			return true;
+		case 0x0d:	// DSKRST
+		case 0x2b:	// SDATE
+		case 0x2d:	// STIME
+		case 0x46:	// ENSURE
+		case 0x63:	// DEFAB
+		case 0x64:	// DEFER
+		case 0x70:	// REDIR
+		case 0x71:	// FOUT
+			if (REG_C(msx) == 0x46 && REG_B(msx) < MSX_MAX_HANDLES && msx->handles[REG_B(msx)].fp) {
+				fflush(msx->handles[REG_B(msx)].fp);
+			}
+			break;
+		case 0x19:	// CURDRV
+			REG_A(msx) = REG_L(msx) = 0;
+			return true;
+		case 0x2a:	// GDATE: fixed date, so the runs are deterministic
+			REG_HL(msx) = 2024; REG_D(msx) = 1; REG_E(msx) = 1;
+			REG_A(msx) = 1;
+			return true;
+		case 0x2c:	// GTIME
+			REG_H(msx) = 12; REG_L(msx) = 0; REG_D(msx) = 0; REG_E(msx) = 0;
+			REG_A(msx) = 0;
+			return true;
+		case 0x40:	// FFIRST
+		case 0x41:	// FNEXT
+			error = dosFind(msx, REG_C(msx) == 0x40);
+			break;
+		case 0x43:	// OPEN
+		case 0x44:	// CREATE
+			error = dosOpen(msx, REG_C(msx) == 0x44);
+			break;
+		case 0x45:	// CLOSE
+			h = REG_B(msx);
+			if (getHandle(msx, h, &error)) {
+				fclose(msx->handles[h].fp);
+				msx->handles[h].fp = NULL;
+			}
+			break;
+		case 0x48:	// READ
+		case 0x49:	// WRITE
+			error = dosRead(msx, REG_C(msx) == 0x49);
+			break;
+		case 0x4a:	// SEEK
+			error = dosSeek(msx);
+			break;
+		case 0x4b:	// IOCTL
+			REG_DE(msx) = REG_B(msx) < FIRST_HANDLE ? 0x80 : 0x00;
+			break;
+		case 0x4d:	// DELETE
+			error = dosDelete(msx);
+			break;
+		case 0x4e:	// RENAME
+			error = dosRename(msx);
+			break;
+		case 0x59:	// GETCD
+			writeString(msx, REG_DE(msx), "");
+			break;
+		case 0x62:	// TERM
+			terminate(msx, REG_B(msx));
+			return true;
+		case 0x65:	// ERROR
+			REG_B(msx) = 0;
+			break;
+		case 0x66:	// EXPLAIN
+			{
+				char text[32];
+				snprintf(text, sizeof(text), "Error %02Xh", REG_B(msx));
+				writeString(msx, REG_DE(msx), text);
+				REG_B(msx) = 0;
+			}
+			break;
+		case 0x6b:	// GENV
+			error = dosGetEnv(msx);
+			break;
+		case 0x6f:	// DOSVER
+			REG_BC(msx) = 0x0231;
+			REG_DE(msx) = 0x0220;
+			break;
+		default:
+			reportUnsupported(msx, REPORT_DOS, REG_C(msx));
+			error = ERR_IBDOS;
+			break;
+	}
+	REG_A(msx) = error;
+	return true;
+}
+
+
+// ========================================================
+// Traps
+
+static bool trap(Msx_t *msx, uint16_t pc)
+{
+	uint16_t ret;
+
+	switch (pc) {
+		case 0x0000:
+			terminate(msx, 0);
+			return true;
+		case BDOS:
+			return bdos(msx);
+		case RDSLT:
+			REG_A(msx) = (REG_A(msx) == msx->mem[EXPTBL] && REG_HL(msx) < 0x8000) ? msx->rom[REG_HL(msx)] : 0xff;
+			return true;
+		case CALSLT:
+			return interSlotCall(msx, msx->cpu.iy.b.h, REG_IX(msx));
+		case CALLF:
+			ret = peek16(msx, msx->cpu.sp.w);
+			if (!interSlotCall(msx, msx->mem[ret], peek16(msx, ret + 1))) return false;
+			poke16(msx, msx->cpu.sp.w, ret + 3);
+			return true;
+		case KEYINT:
+			poke16(msx, JIFFY, peek16(msx, JIFFY) + 1);
+			msx->vdpStatus[0] &= 0x7f;
+			msx->irqPending = false;
+			if (msx->mem[H_TIMI] != 0xc9) reportUnsupported(msx, REPORT_HOOK, H_TIMI);
+			msx->cpu.iff1 = msx->cpu.iff2 = true;
+			msx->cpu.eiDelay = true;
+			return true;
+		default:			// WRSLT, ENASLT
+			return true;
+	}
+}
+
+
+// ========================================================
+// Functions
+
+void msx_init(Msx_t *msx, uint8_t msxVersion)
+{
+	memset(msx, 0, sizeof(Msx_t));
+	msx->rom[MSXVER] = msxVersion;
+	msx->rom[0x0006] = msx->rom[0x0007] = 0x98;		// VDP ports
+	strcpy(msx->drives[0], ".");
+	for (size_t i = 0; i < sizeof(ocm_initialPorts) / sizeof(ocm_initialPorts[0]); i++) {
+		msx->ocmPorts[ocm_initialPorts[i][0]] = ocm_initialPorts[i][1];
+	}
+	msx->cpu.mem = msx->mem;
+	msx->cpu.ctx = msx;
+	msx->cpu.in = ioIn;
+	msx->cpu.out = ioOut;
+	msx->cpu.m1Wait = true;
+	z80_reset(&msx->cpu);
+}
+
+bool msx_mapDrive(Msx_t *msx, char letter, const char *hostDir)
+{
+	uint8_t drive = toupper((uint8_t)letter) - 'A';
+	if (drive >= MSX_MAX_DRIVES || strlen(hostDir) >= MSX_PATHLEN) return false;
+	strcpy(msx->drives[drive], hostDir);
+	return true;
+}
+
+bool msx_setEnv(Msx_t *msx, const char *name, const char *value)
+{
+	for (uint8_t i = 0; i < msx->envCount; i++) {
+		if (!strcasecmp(msx->envNames[i], name)) {
+			free(msx->envValues[i]);
+			msx->envValues[i] = strdup(value);
+			return true;
+		}
+	}
+	if (msx->envCount >= MSX_MAX_ENV) return false;
+	msx->envNames[msx->envCount] = strdup(name);
+	msx->envValues[msx->envCount++] = strdup(value);
+	return true;
+}
+
+void msx_closeFiles(Msx_t *msx)
+{
+	for (uint8_t h = 0; h < MSX_MAX_HANDLES; h++) {
+		if (msx->handles[h].fp) fclose(msx->handles[h].fp);
+		msx->handles[h].fp = NULL;
+	}
+}
+
+/**
+ * Loads a .COM program at 0x0100 and prepares the system area like MSX-DOS 2.
+ * @param args Command line parameters, or NULL.
+ */
+bool msx_loadProgram(Msx_t *msx, const char *file, const char *args)
+{
+	static const uint16_t traps[] = { 0x0000, BDOS, RDSLT, WRSLT, CALSLT, ENASLT, CALLF, KEYINT };
+	Z80 *cpu = &msx->cpu;
+	FILE *fp;
+	size_t size;
+	uint8_t len;
+
+	if (!(fp = fopen(file, "rb"))) return false;
+	memset(msx->mem, 0, sizeof(msx->mem));
+	size = fread(&msx->mem[0x100], 1, MSX_TPA_TOP - 0x100, fp);
+	fclose(fp);
+	if (!size) return false;
+	msx_closeFiles(msx);
+
+	// Page 0: trapped entry points returning with RET
+	for (size_t i = 0; i < sizeof(traps) / sizeof(traps[0]); i++) msx->mem[traps[i]] = 0xc9;
+	poke16(msx, 0x0006, MSX_TPA_TOP);
+
+	// Command line
+	len = args && *args ? snprintf((char*)&msx->mem[0x81], 127, " %s", args) : 0;
+	msx->mem[0x80] = len;
+
+	// Page 3: system variables
+	memset(&msx->mem[HOOKS], 0xc9, EXTBIO + 5 - HOOKS);
+	msx->mem[EXPTBL] = 0x00;
+	msx->mem[EXBRSA] = msx->rom[MSXVER] ? 0x87 : 0x00;
+	msx->mem[HOKVLD] = 0;
+	poke16(msx, PUTPNT, KEYBUF);
+	poke16(msx, GETPNT, KEYBUF);
+	memset(&msx->mem[NEWKEY], 0xff, 11);
+	msx->mem[LINL40] = 80;
+	msx->mem[CRTCNT] = 24;
+	msx->mem[FORCLR] = 15;
+	msx->mem[BAKCLR] = 4;
+	msx->mem[BDRCLR] = 4;
+	msx->mem[OLDSCR] = 0;
+	setTextMode(msx);
+
+	// CPU as left by MSX-DOS: stack at the TPA top with return to 0x0000
+	cpu->sp.w = MSX_TPA_TOP;
+	z80_push16(cpu, 0x0000);
+	cpu->pc.w = 0x0100;
+	cpu->im = 1;
+	cpu->iff1 = cpu->iff2 = true;
+	cpu->halted = false;
+	msx->nextFrame = (cpu->tstates / MSX_FRAME_TSTATES + 1) * MSX_FRAME_TSTATES;
+	msx->state = MSX_RUNNING;
+	msx->escState = 0;
+	return true;
+}
+
+/**
+ * Runs the program until it waits for keys, exits, or maxTstates is reached.
+ */
+MsxState_t msx_run(Msx_t *msx, uint64_t maxTstates)
+{
+	Z80 *cpu = &msx->cpu;
+	bool first = true;					// Do not stop again at the idle point we are resuming from
+
+	if (msx->state == MSX_EXIT) return MSX_EXIT;
+	msx->state = MSX_RUNNING;
+
+	while (msx->state == MSX_RUNNING) {
+		if (cpu->tstates >= maxTstates) return msx->state = MSX_TIMEOUT;
+
+		if (cpu->tstates >= msx->nextFrame) {
+			msx->nextFrame += MSX_FRAME_TSTATES;
+			msx->vdpStatus[0] |= 0x80;
+			if (msx->vdpReg[1] & 0x20) msx->irqPending = true;
+		}
+		if (msx->irqPending) z80_interrupt(cpu, 0xff);
+
+		uint16_t pc = cpu->pc.w;
+		if (!first && msx_keyBufferEmpty(msx) && (msx->idleAddr ? pc == msx->idleAddr : cpu->halted)) {
+			return msx->state = MSX_IDLE;
+		}
+		first = false;
+
+		if (cpu->halted) {
+			if (!cpu->iff1) {
+				fprintf(stderr, "harness: HALT with interrupts disabled at 0x%04X\n", pc);
+				return msx->state = MSX_TIMEOUT;
+			}
+			if (cpu->tstates < msx->nextFrame) cpu->tstates = msx->nextFrame;
+			continue;
+		}
+		if (pc < TRAP_LIMIT && msx->mem[pc] == 0xc9 && !trap(msx, pc)) {
+			return msx->state = MSX_IDLE;
+		}
+		if (msx->state != MSX_RUNNING) break;
+		z80_step(cpu);
+	}
+	return msx->state;
+}
+
+static char screenChar(uint8_t ch)
+{
+	if (ch >= 0x20 && ch < 0x7f) return ch;
+	switch (ch) {
+		case 0x16: return '|';
+		case 0x17: return '-';
+		case 0x10: case 0x11: case 0x12: case 0x13: case 0x14: case 0x15:
+		case 0x18: case 0x19: case 0x1a: case 0x1b: return '+';
+		default: return '.';
+	}
+}
+
+/**
+ * Writes the text screen, followed by the blinking cells marked with '^'.
+ */
+void msx_dumpScreen(Msx_t *msx, FILE *out)
+{
+	uint8_t width = screenWidth(msx), height = screenHeight(msx);
+	uint32_t names = nameTable(msx), blink = blinkTable(msx);
+	char line[81];
+	bool anyBlink = false;
+
+	for (uint8_t y = 0; y < height; y++) {
+		for (uint8_t x = 0; x < width; x++) line[x] = screenChar(vramRead(msx, names + y * width + x));
+		line[width] = '\0';
+		fprintf(out, "%s\n", line);
+	}
+	if (!isText2(msx)) return;
+
+	for (uint8_t y = 0; y < height; y++) {
+		bool rowBlink = false;
+		for (uint8_t x = 0; x < width; x++) {
+			uint8_t bits = vramRead(msx, blink + y * 10 + x / 8);
+			line[x] = (bits & (0x80 >> (x & 7))) ? '^' : ' ';
+			rowBlink |= line[x] == '^';
+		}
+		if (!rowBlink) continue;
+		if (!anyBlink) fprintf(out, "--- blink ---\n");
+		anyBlink = true;
+		line[width] = '\0';
+		fprintf(out, "%02u %s\n", y + 1, line);
+	}
+}
@@ -0,0 +1,116 @@
+/*
+	Copyright (c) 2024 Natalia Pujol Cremades
+	info@abitwitches.com
+
+	See LICENSE file.
+
+	- - - - - - - - - - - - - - - - - - - - - - - -
+
+	Minimal MSX2 + MSX-DOS2 machine for the host harness.
+
+	64KB of flat RAM, the BIOS and DOS entry points are trapped and served
+	in C, the VDP keeps the VRAM and registers needed by the text modes, and
+	the OCM switched I/O ports use the command table of ocm_ioports.tcl.
+	Files are read and written in a host directory.
+
+	Only the program code is timed: T-states spent inside the trapped BIOS
+	and DOS functions are not counted.
+*/
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include "z80.h"
+
+
+// ========================================================
+// Defines
+
+#define MSX_CLOCK			3579545
+#define MSX_FRAME_TSTATES	59736			// 228 T-states x 262 lines (NTSC)
+
+#define MSX_MAX_HANDLES		64
+#define MSX_MAX_ENV			16
+#define MSX_MAX_DRIVES		8
+#define MSX_PATHLEN			512
+#define MSX_TPA_TOP			0xd806
+
+
+// ========================================================
+// Struct & Enums
+
+typedef enum {
+	MSX_RUNNING,
+	MSX_IDLE,							// Waiting for keys with the key buffer empty
+	MSX_EXIT,							// Program terminated
+	MSX_TIMEOUT,
+} MsxState_t;
+
+typedef struct {
+	FILE    *fp;
+	char     path[MSX_PATHLEN];
+} MsxHandle_t;
+
+typedef struct {
+	uint16_t fib;						// FIB address of the search
+	char     dir[MSX_PATHLEN];
+	char     pattern[13];
+	uint8_t  attributes;
+	long     next;						// Next directory entry to check
+} MsxSearch_t;
+
+typedef struct {
+	Z80      cpu;
+	uint8_t  mem[0x10000];
+	uint8_t  rom[0x8000];				// Main BIOS ROM bytes read with RDSLT
+
+	// VDP
+	uint8_t  vram[0x20000];
+	uint8_t  vdpReg[48];
+	uint8_t  vdpStatus[10];
+	uint32_t vramAddr;
+	uint8_t  vdpLatch;
+	bool     vdpLatchFull;
+	uint8_t  vdpReadAhead;
+
+	// OCM switched I/O ports
+	uint8_t  ocmPorts[256];
+	uint8_t  ocmId;
+	uint8_t  ocmPort41;
+	uint8_t  ocmPort4bId;
+	uint8_t  ppi[4];					// PPI ports 0xA8-0xAB
+
+	// MSX-DOS
+	char     drives[MSX_MAX_DRIVES][MSX_PATHLEN];	// Host directory of each drive (A: is 0)
+	MsxHandle_t handles[MSX_MAX_HANDLES];
+	MsxSearch_t search;
+	char    *envNames[MSX_MAX_ENV];
+	char    *envValues[MSX_MAX_ENV];
+	uint8_t  envCount;
+	uint8_t  escState;					// VT-52 escape sequence parsing
+	uint8_t  escRow;
+
+	// Run state
+	MsxState_t state;
+	uint8_t  exitCode;
+	uint16_t idleAddr;					// kbhit() address, or 0 to detect idle at HALT
+	bool     irqPending;
+	uint64_t nextFrame;
+	FILE    *console;					// Copy of the console output, or NULL
+	uint32_t reported[64];				// Unsupported calls already reported
+	uint8_t  reportedCount;
+} Msx_t;
+
+
+// ========================================================
+// Functions
+
+void msx_init(Msx_t *msx, uint8_t msxVersion);
+bool msx_mapDrive(Msx_t *msx, char letter, const char *hostDir);
+bool msx_setEnv(Msx_t *msx, const char *name, const char *value);
+bool msx_loadProgram(Msx_t *msx, const char *file, const char *args);
+MsxState_t msx_run(Msx_t *msx, uint64_t maxTstates);
+bool msx_keyBufferEmpty(Msx_t *msx);
+bool msx_pushKeys(Msx_t *msx, const uint8_t *keys, uint16_t count);
+void msx_dumpScreen(Msx_t *msx, FILE *out);
+void msx_closeFiles(Msx_t *msx);
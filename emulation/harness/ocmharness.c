@@ -0,0 +1,320 @@
+/*
+	Copyright (c) 2024 Natalia Pujol Cremades
+	info@abitwitches.com
+
+	See LICENSE file.
+
+	- - - - - - - - - - - - - - - - - - - - - - - -
+
+	Host-native harness: runs OCMINFO.COM on the embedded Z80 and a minimal
+	MSX-DOS2, following a scenario script like emulation/bench.tcl does, and
+	reports the T-states of each measured scenario in the bench CSV format
+	(cycles358 column: the Z80 runs at the standard 3.58MHz clock).
+
+	Usage: ocmharness [options] SCRIPT.scn
+	  -d DIR         Host directory of drive A: (default: current directory)
+	  -D X=DIR       Host directory of drive X:
+	  -e NAME=VALUE  MSX-DOS environment item
+	  -c FILE        Output CSV file (default: stdout)
+	  -o FILE        Final screen dump ('-' for stdout)
+	  -l FILE        Copy of the console output
+	  -n FILE        NoICE symbols file, to stop at _kbhit instead of HALT
+	  -m VERSION     MSX version at 0x002D: 0=MSX1, 1=MSX2, 2=MSX2+, 3=turboR (default: 3)
+	  -t SECONDS     Emulated timeout of each action (default: 600)
+
+	Script actions (one per line, '#' starts a comment):
+	  run NAME [ARGS]  Load NAME.COM from drive A:, stopped at its entry point
+	  begin NAME       Start measuring a scenario
+	  keys KEYS        Inject the keys and wait until the program is idle again
+	  wait_idle        Wait until the program is idle
+	  wait_exit        Wait until the program returns to DOS
+	  end              Record the measured scenario
+	  screen FILE      Dump the current screen
+	KEYS are quoted strings, single chars, or the names ENTER, ESC, TAB, BS,
+	SPACE, UP, DOWN, LEFT, RIGHT, HOME, INS and DEL.
+*/
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <dirent.h>
+#include <getopt.h>
+#include "msx.h"
+
+
+// ========================================================
+// Defines
+
+#define LINE_LEN		512
+#define MAX_KEYS		256
+#define MAX_RESULTS		64
+#define FRAME_RATE		59.94
+
+typedef struct {
+	char     name[64];
+	uint16_t steps;
+	uint64_t tstates;
+} Result_t;
+
+typedef struct {
+	const char *name;
+	uint8_t code;
+} KeyName_t;
+
+static const KeyName_t keyNames[] = {
+	{ "ENTER", 13 }, { "ESC", 27 }, { "TAB", 9 }, { "BS", 8 }, { "SPACE", 32 },
+	{ "UP", 30 }, { "DOWN", 31 }, { "LEFT", 29 }, { "RIGHT", 28 },
+	{ "HOME", 11 }, { "INS", 18 }, { "DEL", 127 },
+};
+
+
+// ========================================================
+// Global variables
+
+static Msx_t *msx;
+static Result_t results[MAX_RESULTS];
+static uint8_t resultsCount;
+static uint64_t timeout = 600ull * MSX_CLOCK;
+static const char *scriptName;
+static int lineNumber;
+
+
+// ========================================================
+// Helpers
+
+static void die(const char *msg, const char *arg)
+{
+	fprintf(stderr, "ocmharness: ");
+	if (scriptName && lineNumber) fprintf(stderr, "%s:%d: ", scriptName, lineNumber);
+	fprintf(stderr, msg, arg);
+	fprintf(stderr, "\n");
+	exit(1);
+}
+
+static uint16_t findSymbol(const char *file, const char *name)
+{
+	char line[LINE_LEN], def[16], symbol[128], addr[32];
+	FILE *fp = fopen(file, "r");
+	uint16_t result = 0;
+
+	if (!fp) die("cannot open '%s'", file);
+	while (fgets(line, sizeof(line), fp)) {
+		if (sscanf(line, "%15s %127s %31s", def, symbol, addr) == 3 && !strcmp(def, "DEF") && !strcmp(symbol, name)) {
+			result = strtoul(addr, NULL, 0);
+			break;
+		}
+	}
+	fclose(fp);
+	if (!result) die("symbol '%s' not found", name);
+	return result;
+}
+
+// Finds NAME.COM in the drive A: directory, ignoring case
+static bool findProgram(const char *name, char *path)
+{
+	char wanted[64];
+	struct dirent *entry;
+	DIR *dp;
+	bool found = false;
+
+	snprintf(wanted, sizeof(wanted), "%s%s", name, strchr(name, '.') ? "" : ".COM");
+	if (!(dp = opendir(msx->drives[0]))) return false;
+	while ((entry = readdir(dp))) {
+		if (!strcasecmp(entry->d_name, wanted)) {
+			snprintf(path, MSX_PATHLEN, "%s/%s", msx->drives[0], entry->d_name);
+			found = true;
+			break;
+		}
+	}
+	closedir(dp);
+	return found;
+}
+
+// Parses the keys of a 'keys' action
+static uint16_t parseKeys(char *text, uint8_t *keys)
+{
+	uint16_t count = 0;
+	char *token;
+
+	while (*text) {
+		while (isspace((uint8_t)*text)) text++;
+		if (!*text) break;
+		if (*text == '"') {
+			for (text++; *text && *text != '"' && count < MAX_KEYS; text++) keys[count++] = *text;
+			if (*text) text++;
+			continue;
+		}
+		token = text;
+		while (*text && !isspace((uint8_t)*text)) text++;
+		if (*text) *text++ = '\0';
+		if (strlen(token) == 1) {
+			keys[count++] = token[0];
+			continue;
+		}
+		size_t i;
+		for (i = 0; i < sizeof(keyNames) / sizeof(keyNames[0]); i++) {
+			if (!strcasecmp(keyNames[i].name, token)) break;
+		}
+		if (i == sizeof(keyNames) / sizeof(keyNames[0])) die("unknown key '%s'", token);
+		if (count < MAX_KEYS) keys[count++] = keyNames[i].code;
+	}
+	return count;
+}
+
+
+// ========================================================
+// Actions
+
+static MsxState_t runUntil(MsxState_t wanted)
+{
+	MsxState_t state = msx_run(msx, msx->cpu.tstates + timeout);
+
+	// The program can exit while waiting for it to be idle (i.e. the quit keys)
+	if (state == MSX_TIMEOUT) die("timeout waiting for the program%s", "");
+	if (state == MSX_IDLE && wanted == MSX_EXIT) {
+		die("the program is waiting for keys instead of exiting%s", "");
+	}
+	return state;
+}
+
+static void actionRun(char *args)
+{
+	char path[MSX_PATHLEN], *name = strtok(args, " \t");
+	char *params = strtok(NULL, "");
+
+	if (!name) die("missing program name%s", "");
+	if (!findProgram(name, path)) die("program '%s' not found in drive A:", name);
+	while (params && isspace((uint8_t)*params)) params++;
+	if (!msx_loadProgram(msx, path, params)) die("cannot load '%s'", path);
+}
+
+static void writeScreen(const char *file)
+{
+	FILE *fp = strcmp(file, "-") ? fopen(file, "w") : stdout;
+	if (!fp) die("cannot create '%s'", file);
+	msx_dumpScreen(msx, fp);
+	if (fp != stdout) fclose(fp);
+}
+
+static void runScript(const char *file)
+{
+	char line[LINE_LEN], *action, *args, *p;
+	uint8_t keys[MAX_KEYS];
+	Result_t *current = NULL;
+	uint64_t start = 0;
+	FILE *fp;
+
+	scriptName = file;
+	if (!(fp = fopen(file, "r"))) die("cannot open '%s'", file);
+	while (fgets(line, sizeof(line), fp)) {
+		lineNumber++;
+		if ((p = strchr(line, '#'))) *p = '\0';
+		if (!(action = strtok(line, " \t\r\n"))) continue;
+		args = strtok(NULL, "\r\n");
+		if (!args) args = "";
+
+		if (!strcmp(action, "run")) {
+			actionRun(args);
+		} else
+		if (!strcmp(action, "begin")) {
+			if (resultsCount >= MAX_RESULTS) die("too many scenarios%s", "");
+			current = &results[resultsCount];
+			memset(current, 0, sizeof(Result_t));
+			snprintf(current->name, sizeof(current->name), "%s", strtok(args, " \t"));
+			start = msx->cpu.tstates;
+		} else
+		if (!strcmp(action, "keys")) {
+			uint16_t count = parseKeys(args, keys);
+			if (msx->state == MSX_EXIT) die("the program is not running%s", "");
+			if (!msx_pushKeys(msx, keys, count)) die("key buffer full%s", "");
+			if (current) current->steps++;
+			runUntil(MSX_IDLE);
+		} else
+		if (!strcmp(action, "wait_idle")) {
+			if (msx->state != MSX_IDLE) runUntil(MSX_IDLE);
+		} else
+		if (!strcmp(action, "wait_exit")) {
+			if (msx->state != MSX_EXIT) runUntil(MSX_EXIT);
+		} else
+		if (!strcmp(action, "end")) {
+			if (!current) die("'end' without 'begin'%s", "");
+			current->tstates = msx->cpu.tstates - start;
+			resultsCount++;
+			current = NULL;
+		} else
+		if (!strcmp(action, "screen")) {
+			writeScreen(strtok(args, " \t"));
+		} else {
+			die("unknown action '%s'", action);
+		}
+	}
+	fclose(fp);
+	lineNumber = 0;
+}
+
+static void writeCsv(const char *file)
+{
+	FILE *fp = file ? fopen(file, "w") : stdout;
+
+	if (!fp) die("cannot create '%s'", file);
+	fprintf(fp, "scenario,steps,usecs,cycles358,frames\n");
+	for (uint8_t i = 0; i < resultsCount; i++) {
+		double seconds = (double)results[i].tstates / MSX_CLOCK;
+		fprintf(fp, "%s,%u,%.0f,%llu,%.2f\n", results[i].name, results[i].steps,
+			seconds * 1000000, (unsigned long long)results[i].tstates, seconds * FRAME_RATE);
+	}
+	if (fp != stdout) fclose(fp);
+}
+
+
+// ========================================================
+// MAIN
+
+int main(int argc, char **argv)
+{
+	const char *csvFile = NULL, *screenFile = NULL, *consoleFile = NULL, *noiFile = NULL;
+	char *value;
+	int opt;
+
+	if (!(msx = malloc(sizeof(Msx_t)))) die("out of memory%s", "");
+	msx_init(msx, 3);
+
+	while ((opt = getopt(argc, argv, "d:D:e:c:o:l:n:m:t:")) != -1) {
+		switch (opt) {
+			case 'd':
+				msx_mapDrive(msx, 'A', optarg);
+				break;
+			case 'D':
+				if (optarg[1] != '=' || !msx_mapDrive(msx, optarg[0], optarg + 2)) die("bad drive '%s'", optarg);
+				break;
+			case 'e':
+				if (!(value = strchr(optarg, '='))) die("bad environment item '%s'", optarg);
+				*value++ = '\0';
+				if (!msx_setEnv(msx, optarg, value)) die("too many environment items%s", "");
+				break;
+			case 'c': csvFile = optarg; break;
+			case 'o': screenFile = optarg; break;
+			case 'l': consoleFile = optarg; break;
+			case 'n': noiFile = optarg; break;
+			case 'm': msx->rom[0x002d] = atoi(optarg); break;
+			case 't': timeout = strtoull(optarg, NULL, 10) * MSX_CLOCK; break;
+			default:
+				fprintf(stderr, "Usage: %s [-d dir] [-D X=dir] [-e NAME=VALUE] [-c csv] [-o screen] "
+					"[-l console] [-n noi] [-m msxver] [-t secs] SCRIPT\n", argv[0]);
+				return 1;
+		}
+	}
+	if (optind >= argc) die("missing script file%s", "");
+
+	if (noiFile) msx->idleAddr = findSymbol(noiFile, "_kbhit");
+	if (consoleFile && !(msx->console = fopen(consoleFile, "w"))) die("cannot create '%s'", consoleFile);
+
+	runScript(argv[optind]);
+
+	writeCsv(csvFile);
+	if (screenFile) writeScreen(screenFile);
+	msx_closeFiles(msx);
+	if (msx->console) fclose(msx->console);
+	free(msx);
+	return 0;
+}
@@ -0,0 +1,719 @@
+/*
+	Copyright (c) 2024 Natalia Pujol Cremades
+	info@abitwitches.com
+
+	See LICENSE file.
+*/
+#include <string.h>
+#include "z80.h"
+
+
+// ========================================================
+// Defines
+
+#define A		cpu->af.b.h
+#define F		cpu->af.b.l
+#define B		cpu->bc.b.h
+#define C		cpu->bc.b.l
+#define BC		cpu->bc.w
+#define DE		cpu->de.w
+#define HL		cpu->hl.w
+#define SP		cpu->sp.w
+#define PC		cpu->pc.w
+#define WZ		cpu->wz
+
+#define FC		Z80_FLAG_C
+#define FN		Z80_FLAG_N
+#define FPV		Z80_FLAG_PV
+#define FX		Z80_FLAG_X
+#define FH		Z80_FLAG_H
+#define FY		Z80_FLAG_Y
+#define FZ		Z80_FLAG_Z
+#define FS		Z80_FLAG_S
+#define FXY		(FX|FY)
+
+
+// ========================================================
+// Tables
+
+// Unprefixed opcodes T-states (conditional jumps/calls/returns not taken)
+static const uint8_t cycles[256] = {
+	 4,10, 7, 6, 4, 4, 7, 4, 4,11, 7, 6, 4, 4, 7, 4,
+	 8,10, 7, 6, 4, 4, 7, 4,12,11, 7, 6, 4, 4, 7, 4,
+	 7,10,16, 6, 4, 4, 7, 4, 7,11,16, 6, 4, 4, 7, 4,
+	 7,10,13, 6,11,11,10, 4, 7,11,13, 6, 4, 4, 7, 4,
+	 4, 4, 4, 4, 4, 4, 7, 4, 4, 4, 4, 4, 4, 4, 7, 4,
+	 4, 4, 4, 4, 4, 4, 7, 4, 4, 4, 4, 4, 4, 4, 7, 4,
+	 4, 4, 4, 4, 4, 4, 7, 4, 4, 4, 4, 4, 4, 4, 7, 4,
+	 7, 7, 7, 7, 7, 7, 4, 7, 4, 4, 4, 4, 4, 4, 7, 4,
+	 4, 4, 4, 4, 4, 4, 7, 4, 4, 4, 4, 4, 4, 4, 7, 4,
+	 4, 4, 4, 4, 4, 4, 7, 4, 4, 4, 4, 4, 4, 4, 7, 4,
+	 4, 4, 4, 4, 4, 4, 7, 4, 4, 4, 4, 4, 4, 4, 7, 4,
+	 4, 4, 4, 4, 4, 4, 7, 4, 4, 4, 4, 4, 4, 4, 7, 4,
+	 5,10,10,10,10,11, 7,11, 5,10,10, 0,10,17, 7,11,
+	 5,10,10,11,10,11, 7,11, 5, 4,10,11,10, 0, 7,11,
+	 5,10,10,19,10,11, 7,11, 5, 4,10, 4,10, 0, 7,11,
+	 5,10,10, 4,10,11, 7,11, 5, 6,10, 4,10, 0, 7,11,
+};
+
+static uint8_t sz53[256];				// Sign, zero, X & Y flags of a byte
+static uint8_t sz53p[256];				// The same plus parity
+static bool tablesReady = false;
+
+
+// ========================================================
+// Helpers
+
+static void initTables()
+{
+	for (int i = 0; i < 256; i++) {
+		uint8_t parity = 0;
+		for (int bit = 0; bit < 8; bit++) parity ^= (i >> bit) & 1;
+		sz53[i] = (i & (FS|FXY)) | (i ? 0 : FZ);
+		sz53p[i] = sz53[i] | (parity ? 0 : FPV);
+	}
+	tablesReady = true;
+}
+
+static inline uint8_t fetchOp(Z80 *cpu)
+{
+	cpu->r = (cpu->r & 0x80) | ((cpu->r + 1) & 0x7f);
+	if (cpu->m1Wait) cpu->tstates++;
+	return cpu->mem[PC++];
+}
+
+static inline uint8_t fetch8(Z80 *cpu)
+{
+	return cpu->mem[PC++];
+}
+
+static inline uint16_t fetch16(Z80 *cpu)
+{
+	uint16_t value = cpu->mem[PC] | (cpu->mem[(uint16_t)(PC + 1)] << 8);
+	PC += 2;
+	return value;
+}
+
+static inline uint16_t read16(Z80 *cpu, uint16_t addr)
+{
+	return cpu->mem[addr] | (cpu->mem[(uint16_t)(addr + 1)] << 8);
+}
+
+static inline void write16(Z80 *cpu, uint16_t addr, uint16_t value)
+{
+	cpu->mem[addr] = value & 0xff;
+	cpu->mem[(uint16_t)(addr + 1)] = value >> 8;
+}
+
+void z80_push16(Z80 *cpu, uint16_t value)
+{
+	SP -= 2;
+	write16(cpu, SP, value);
+}
+
+uint16_t z80_pop16(Z80 *cpu)
+{
+	uint16_t value = read16(cpu, SP);
+	SP += 2;
+	return value;
+}
+
+static inline bool condition(Z80 *cpu, uint8_t cc)
+{
+	switch (cc) {
+		case 0: return !(F & FZ);
+		case 1: return F & FZ;
+		case 2: return !(F & FC);
+		case 3: return F & FC;
+		case 4: return !(F & FPV);
+		case 5: return F & FPV;
+		case 6: return !(F & FS);
+		default: return F & FS;
+	}
+}
+
+// Register r (0:B 1:C 2:D 3:E 4:H 5:L 7:A), H & L replaced by the index register halves
+static inline uint8_t *reg8(Z80 *cpu, uint8_t r, Z80Pair_t *xy)
+{
+	switch (r) {
+		case 0: return &cpu->bc.b.h;
+		case 1: return &cpu->bc.b.l;
+		case 2: return &cpu->de.b.h;
+		case 3: return &cpu->de.b.l;
+		case 4: return &xy->b.h;
+		case 5: return &xy->b.l;
+		default: return &cpu->af.b.h;
+	}
+}
+
+static inline uint16_t *reg16(Z80 *cpu, uint8_t p, Z80Pair_t *xy)
+{
+	switch (p) {
+		case 0: return &cpu->bc.w;
+		case 1: return &cpu->de.w;
+		case 2: return &xy->w;
+		default: return &cpu->sp.w;
+	}
+}
+
+
+// ========================================================
+// ALU
+
+static inline void add8(Z80 *cpu, uint8_t value, uint8_t carry)
+{
+	uint16_t res = A + value + carry;
+	F = sz53[res & 0xff] | ((A ^ value ^ res) & FH) |
+		(((A ^ ~value) & (A ^ res) & 0x80) ? FPV : 0) | (res >> 8);
+	A = res;
+}
+
+static inline uint8_t sub8(Z80 *cpu, uint8_t value, uint8_t carry)
+{
+	uint16_t res = A - value - carry;
+	F = sz53[res & 0xff] | FN | ((A ^ value ^ res) & FH) |
+		(((A ^ value) & (A ^ res) & 0x80) ? FPV : 0) | ((res >> 8) & FC);
+	return res;
+}
+
+static void alu(Z80 *cpu, uint8_t op, uint8_t value)
+{
+	switch (op) {
+		case 0: add8(cpu, value, 0); break;
+		case 1: add8(cpu, value, F & FC); break;
+		case 2: A = sub8(cpu, value, 0); break;
+		case 3: A = sub8(cpu, value, F & FC); break;
+		case 4: A &= value; F = sz53p[A] | FH; break;
+		case 5: A ^= value; F = sz53p[A]; break;
+		case 6: A |= value; F = sz53p[A]; break;
+		default:
+			sub8(cpu, value, 0);
+			F = (F & ~FXY) | (value & FXY);
+			break;
+	}
+}
+
+static inline uint8_t inc8(Z80 *cpu, uint8_t value)
+{
+	uint8_t res = value + 1;
+	F = (F & FC) | sz53[res] | ((res & 0x0f) ? 0 : FH) | (res == 0x80 ? FPV : 0);
+	return res;
+}
+
+static inline uint8_t dec8(Z80 *cpu, uint8_t value)
+{
+	uint8_t res = value - 1;
+	F = (F & FC) | FN | sz53[res] | ((value & 0x0f) ? 0 : FH) | (res == 0x7f ? FPV : 0);
+	return res;
+}
+
+static inline uint16_t add16(Z80 *cpu, uint16_t a, uint16_t value)
+{
+	uint32_t res = a + value;
+	WZ = a + 1;
+	F = (F & (FS|FZ|FPV)) | ((res >> 8) & FXY) | (((a ^ value ^ res) >> 8) & FH) | (res >> 16);
+	return res;
+}
+
+static inline void adc16(Z80 *cpu, uint16_t value)
+{
+	uint32_t res = HL + value + (F & FC);
+	WZ = HL + 1;
+	F = ((res >> 8) & (FS|FXY)) | ((res & 0xffff) ? 0 : FZ) | (((HL ^ value ^ res) >> 8) & FH) |
+		(((HL ^ ~value) & (HL ^ res) & 0x8000) ? FPV : 0) | (res >> 16);
+	HL = res;
+}
+
+static inline void sbc16(Z80 *cpu, uint16_t value)
+{
+	uint32_t res = HL - value - (F & FC);
+	WZ = HL + 1;
+	F = FN | ((res >> 8) & (FS|FXY)) | ((res & 0xffff) ? 0 : FZ) | (((HL ^ value ^ res) >> 8) & FH) |
+		(((HL ^ value) & (HL ^ res) & 0x8000) ? FPV : 0) | ((res >> 16) & FC);
+	HL = res;
+}
+
+static uint8_t rotate(Z80 *cpu, uint8_t op, uint8_t value)
+{
+	uint8_t res, carry;
+	switch (op) {
+		case 0: carry = value >> 7; res = (value << 1) | carry; break;					// RLC
+		case 1: carry = value & 1; res = (value >> 1) | (carry << 7); break;			// RRC
+		case 2: carry = value >> 7; res = (value << 1) | (F & FC); break;				// RL
+		case 3: carry = value & 1; res = (value >> 1) | ((F & FC) << 7); break;		// RR
+		case 4: carry = value >> 7; res = value << 1; break;							// SLA
+		case 5: carry = value & 1; res = (value >> 1) | (value & 0x80); break;			// SRA
+		case 6: carry = value >> 7; res = (value << 1) | 1; break;						// SLL
+		default: carry = value & 1; res = value >> 1; break;							// SRL
+	}
+	F = sz53p[res] | carry;
+	return res;
+}
+
+static void daa(Z80 *cpu)
+{
+	uint8_t diff = 0, carry = F & FC, half;
+	if ((F & FH) || (A & 0x0f) > 9) diff |= 0x06;
+	if (carry || A > 0x99) { diff |= 0x60; carry = FC; }
+	if (F & FN) {
+		half = ((F & FH) && (A & 0x0f) < 6) ? FH : 0;
+		A -= diff;
+	} else {
+		half = ((A & 0x0f) > 9) ? FH : 0;
+		A += diff;
+	}
+	F = sz53p[A] | (F & FN) | carry | half;
+}
+
+
+// ========================================================
+// CB prefix
+
+static uint8_t execCB(Z80 *cpu, uint8_t op, uint16_t addr, bool indexed)
+{
+	uint8_t x = op >> 6, y = (op >> 3) & 7, z = op & 7;
+	bool memory = indexed || z == 6;
+	uint8_t *reg = memory ? NULL : reg8(cpu, z, &cpu->hl);
+	uint8_t value = memory ? cpu->mem[addr] : *reg;
+	uint8_t res;
+
+	switch (x) {
+		case 0: res = rotate(cpu, y, value); break;
+		case 1:
+			F = (F & FC) | FH | ((value & (1 << y)) ? (y == 7 ? FS : 0) : (FZ|FPV)) |
+				((memory ? (WZ >> 8) : value) & FXY);
+			if (indexed) return 20;
+			return memory ? 12 : 8;
+		case 2: res = value & ~(1 << y); break;
+		default: res = value | (1 << y); break;
+	}
+
+	if (memory) {
+		cpu->mem[addr] = res;
+		if (indexed && z != 6) *reg8(cpu, z, &cpu->hl) = res;		// Undocumented copy to register
+	} else {
+		*reg = res;
+	}
+	if (indexed) return 23;
+	return memory ? 15 : 8;
+}
+
+
+// ========================================================
+// ED prefix
+
+static uint8_t blockOp(Z80 *cpu, uint8_t y, uint8_t z)
+{
+	bool dec = y & 1, repeat = y & 2;
+	int8_t step = dec ? -1 : 1;
+	uint8_t value, n;
+	uint16_t k;
+
+	switch (z) {
+		case 0:		// LDI/LDD/LDIR/LDDR
+			value = cpu->mem[HL];
+			cpu->mem[DE] = value;
+			HL += step; DE += step; BC--;
+			n = value + A;
+			F = (F & (FS|FZ|FC)) | (BC ? FPV : 0) | (n & FX) | ((n & 0x02) << 4);
+			if (repeat && BC) { PC -= 2; WZ = PC + 1; return 21; }
+			return 16;
+		case 1:		// CPI/CPD/CPIR/CPDR
+			value = cpu->mem[HL];
+			{
+				uint8_t res = A - value;
+				uint8_t half = (A ^ value ^ res) & FH;
+				n = res - (half ? 1 : 0);
+				HL += step; BC--; WZ += step;
+				F = (F & FC) | FN | (sz53[res] & (FS|FZ)) | half | (BC ? FPV : 0) | (n & FX) | ((n & 0x02) << 4);
+				if (repeat && BC && res) { PC -= 2; WZ = PC + 1; return 21; }
+			}
+			return 16;
+		case 2:		// INI/IND/INIR/INDR
+			value = cpu->in(cpu->ctx, BC);
+			WZ = BC + step;
+			cpu->mem[HL] = value;
+			B--; HL += step;
+			k = value + ((C + step) & 0xff);
+			break;
+		default:	// OUTI/OUTD/OTIR/OTDR
+			value = cpu->mem[HL];
+			B--;
+			cpu->out(cpu->ctx, BC, value);
+			HL += step;
+			WZ = BC + step;
+			k = value + cpu->hl.b.l;
+			break;
+	}
+	F = sz53[B] | ((value & 0x80) ? FN : 0) | (k > 255 ? (FH|FC) : 0) | (sz53p[(k & 7) ^ B] & FPV);
+	if (repeat && B) { PC -= 2; return 21; }
+	return 16;
+}
+
+static uint8_t execED(Z80 *cpu, uint8_t op)
+{
+	uint8_t x = op >> 6, y = (op >> 3) & 7, z = op & 7, p = y >> 1, q = y & 1;
+	uint8_t value;
+	uint16_t addr;
+
+	if (x == 2 && z <= 3 && y >= 4) return blockOp(cpu, y - 4, z);
+	if (x != 1) return 8;
+
+	switch (z) {
+		case 0:		// IN r,(C)
+			value = cpu->in(cpu->ctx, BC);
+			WZ = BC + 1;
+			F = (F & FC) | sz53p[value];
+			if (y != 6) *reg8(cpu, y, &cpu->hl) = value;
+			return 12;
+		case 1:		// OUT (C),r
+			cpu->out(cpu->ctx, BC, y == 6 ? 0 : *reg8(cpu, y, &cpu->hl));
+			WZ = BC + 1;
+			return 12;
+		case 2:		// SBC/ADC HL,rr
+			if (q) adc16(cpu, *reg16(cpu, p, &cpu->hl));
+			else sbc16(cpu, *reg16(cpu, p, &cpu->hl));
+			return 15;
+		case 3:		// LD (nn),rr / LD rr,(nn)
+			addr = fetch16(cpu);
+			WZ = addr + 1;
+			if (q) *reg16(cpu, p, &cpu->hl) = read16(cpu, addr);
+			else write16(cpu, addr, *reg16(cpu, p, &cpu->hl));
+			return 20;
+		case 4:		// NEG
+			value = A;
+			A = 0;
+			A = sub8(cpu, value, 0);
+			return 8;
+		case 5:		// RETN / RETI
+			PC = z80_pop16(cpu);
+			WZ = PC;
+			cpu->iff1 = cpu->iff2;
+			return 14;
+		case 6:		// IM n
+			cpu->im = (y & 3) == 0 || (y & 3) == 1 ? 0 : (y & 3) - 1;
+			return 8;
+		default:
+			switch (y) {
+				case 0: cpu->i = A; return 9;
+				case 1: cpu->r = A; return 9;
+				case 2:
+				case 3:
+					A = y == 2 ? cpu->i : cpu->r;
+					F = (F & FC) | sz53[A] | (cpu->iff2 ? FPV : 0);
+					return 9;
+				case 4:		// RRD
+					value = cpu->mem[HL];
+					cpu->mem[HL] = (A << 4) | (value >> 4);
+					A = (A & 0xf0) | (value & 0x0f);
+					F = (F & FC) | sz53p[A];
+					WZ = HL + 1;
+					return 18;
+				case 5:		// RLD
+					value = cpu->mem[HL];
+					cpu->mem[HL] = (value << 4) | (A & 0x0f);
+					A = (A & 0xf0) | (value >> 4);
+					F = (F & FC) | sz53p[A];
+					WZ = HL + 1;
+					return 18;
+				default:
+					return 8;
+			}
+	}
+}
+
+
+// ========================================================
+// Unprefixed & DD/FD prefixed
+
+// Address of the (HL) operand, or (IX+d)/(IY+d) when prefixed
+static inline uint16_t memOperand(Z80 *cpu, Z80Pair_t *xy, bool indexed)
+{
+	if (!indexed) return HL;
+	WZ = xy->w + (int8_t)fetch8(cpu);
+	return WZ;
+}
+
+static uint8_t exec(Z80 *cpu, uint8_t op, Z80Pair_t *xy, bool indexed)
+{
+	uint8_t x = op >> 6, y = (op >> 3) & 7, z = op & 7, p = y >> 1, q = y & 1;
+	uint8_t t = cycles[op];
+	uint8_t value;
+	uint16_t addr, tmp;
+
+	if (indexed) t += 4;
+
+	switch (x) {
+	case 0:
+		switch (z) {
+		case 0:
+			switch (y) {
+				case 0: break;										// NOP
+				case 1:												// EX AF,AF'
+					tmp = cpu->af.w; cpu->af.w = cpu->af2.w; cpu->af2.w = tmp;
+					break;
+				case 2:												// DJNZ d
+					value = fetch8(cpu);
+					if (--B) { PC += (int8_t)value; WZ = PC; t += 5; }
+					break;
+				case 3:												// JR d
+					value = fetch8(cpu);
+					PC += (int8_t)value; WZ = PC;
+					break;
+				default:											// JR cc,d
+					value = fetch8(cpu);
+					if (condition(cpu, y - 4)) { PC += (int8_t)value; WZ = PC; t += 5; }
+					break;
+			}
+			break;
+		case 1:
+			if (q) *reg16(cpu, 2, xy) = add16(cpu, xy->w, *reg16(cpu, p, xy));
+			else *reg16(cpu, p, xy) = fetch16(cpu);
+			break;
+		case 2:
+			switch (y) {
+				case 0: cpu->mem[BC] = A; WZ = ((BC + 1) & 0xff) | (A << 8); break;
+				case 1: A = cpu->mem[BC]; WZ = BC + 1; break;
+				case 2: cpu->mem[DE] = A; WZ = ((DE + 1) & 0xff) | (A << 8); break;
+				case 3: A = cpu->mem[DE]; WZ = DE + 1; break;
+				case 4: addr = fetch16(cpu); write16(cpu, addr, xy->w); WZ = addr + 1; break;
+				case 5: addr = fetch16(cpu); xy->w = read16(cpu, addr); WZ = addr + 1; break;
+				case 6: addr = fetch16(cpu); cpu->mem[addr] = A; WZ = ((addr + 1) & 0xff) | (A << 8); break;
+				default: addr = fetch16(cpu); A = cpu->mem[addr]; WZ = addr + 1; break;
+			}
+			break;
+		case 3:
+			if (q) (*reg16(cpu, p, xy))--;
+			else (*reg16(cpu, p, xy))++;
+			break;
+		case 4:
+		case 5:
+			if (y == 6) {
+				addr = memOperand(cpu, xy, indexed);
+				if (indexed) t += 8;
+				cpu->mem[addr] = z == 4 ? inc8(cpu, cpu->mem[addr]) : dec8(cpu, cpu->mem[addr]);
+			} else {
+				uint8_t *reg = reg8(cpu, y, xy);
+				*reg = z == 4 ? inc8(cpu, *reg) : dec8(cpu, *reg);
+			}
+			break;
+		case 6:
+			if (y == 6) {
+				addr = memOperand(cpu, xy, indexed);
+				if (indexed) t += 5;
+				cpu->mem[addr] = fetch8(cpu);
+			} else {
+				*reg8(cpu, y, xy) = fetch8(cpu);
+			}
+			break;
+		default:
+			switch (y) {
+				case 0: value = A >> 7; A = (A << 1) | value; F = (F & (FS|FZ|FPV)) | (A & FXY) | value; break;
+				case 1: value = A & 1; A = (A >> 1) | (value << 7); F = (F & (FS|FZ|FPV)) | (A & FXY) | value; break;
+				case 2: value = A >> 7; A = (A << 1) | (F & FC); F = (F & (FS|FZ|FPV)) | (A & FXY) | value; break;
+				case 3: value = A & 1; A = (A >> 1) | ((F & FC) << 7); F = (F & (FS|FZ|FPV)) | (A & FXY) | value; break;
+				case 4: daa(cpu); break;
+				case 5: A = ~A; F = (F & (FS|FZ|FPV|FC)) | FH | FN | (A & FXY); break;
+				case 6: F = (F & (FS|FZ|FPV)) | FC | (A & FXY); break;
+				default: F = (F & (FS|FZ|FPV)) | ((F & FC) ? FH : FC) | (A & FXY); break;
+			}
+			break;
+		}
+		break;
+
+	case 1:
+		if (op == 0x76) {											// HALT
+			cpu->halted = true;
+		} else if (y == 6) {
+			addr = memOperand(cpu, xy, indexed);
+			if (indexed) t += 8;
+			cpu->mem[addr] = *reg8(cpu, z, &cpu->hl);
+		} else if (z == 6) {
+			addr = memOperand(cpu, xy, indexed);
+			if (indexed) t += 8;
+			*reg8(cpu, y, &cpu->hl) = cpu->mem[addr];
+		} else {
+			*reg8(cpu, y, xy) = *reg8(cpu, z, xy);
+		}
+		break;
+
+	case 2:
+		if (z == 6) {
+			addr = memOperand(cpu, xy, indexed);
+			if (indexed) t += 8;
+			value = cpu->mem[addr];
+		} else {
+			value = *reg8(cpu, z, xy);
+		}
+		alu(cpu, y, value);
+		break;
+
+	default:
+		switch (z) {
+		case 0:														// RET cc
+			if (condition(cpu, y)) { PC = z80_pop16(cpu); WZ = PC; t += 6; }
+			break;
+		case 1:
+			if (!q) {												// POP rr
+				tmp = z80_pop16(cpu);
+				if (p == 3) cpu->af.w = tmp; else *reg16(cpu, p, xy) = tmp;
+			} else {
+				switch (p) {
+					case 0: PC = z80_pop16(cpu); WZ = PC; break;		// RET
+					case 1:											// EXX
+						tmp = BC; BC = cpu->bc2.w; cpu->bc2.w = tmp;
+						tmp = DE; DE = cpu->de2.w; cpu->de2.w = tmp;
+						tmp = HL; HL = cpu->hl2.w; cpu->hl2.w = tmp;
+						break;
+					case 2: PC = xy->w; break;						// JP (HL)
+					default: SP = xy->w; break;						// LD SP,HL
+				}
+			}
+			break;
+		case 2:														// JP cc,nn
+			addr = fetch16(cpu);
+			WZ = addr;
+			if (condition(cpu, y)) PC = addr;
+			break;
+		case 3:
+			switch (y) {
+				case 0: PC = fetch16(cpu); WZ = PC; break;			// JP nn
+				case 2:												// OUT (n),A
+					value = fetch8(cpu);
+					cpu->out(cpu->ctx, value | (A << 8), A);
+					WZ = ((value + 1) & 0xff) | (A << 8);
+					break;
+				case 3:												// IN A,(n)
+					value = fetch8(cpu);
+					WZ = ((A << 8) | value) + 1;
+					A = cpu->in(cpu->ctx, value | (A << 8));
+					break;
+				case 4:												// EX (SP),HL
+					tmp = read16(cpu, SP);
+					write16(cpu, SP, xy->w);
+					xy->w = tmp;
+					WZ = tmp;
+					break;
+				case 5:												// EX DE,HL
+					tmp = DE; DE = HL; HL = tmp;
+					break;
+				case 6:												// DI
+					cpu->iff1 = cpu->iff2 = false;
+					break;
+				default:											// EI
+					cpu->iff1 = cpu->iff2 = true;
+					cpu->eiDelay = true;
+					break;
+			}
+			break;
+		case 4:														// CALL cc,nn
+			addr = fetch16(cpu);
+			WZ = addr;
+			if (condition(cpu, y)) { z80_push16(cpu, PC); PC = addr; t += 7; }
+			break;
+		case 5:
+			if (!q) {												// PUSH rr
+				z80_push16(cpu, p == 3 ? cpu->af.w : *reg16(cpu, p, xy));
+			} else {												// CALL nn
+				addr = fetch16(cpu);
+				z80_push16(cpu, PC);
+				PC = addr; WZ = addr;
+			}
+			break;
+		case 6:														// ALU n
+			alu(cpu, y, fetch8(cpu));
+			break;
+		default:													// RST
+			z80_push16(cpu, PC);
+			PC = y << 3; WZ = PC;
+			break;
+		}
+		break;
+	}
+	return t;
+}
+
+
+// ========================================================
+// Functions
+
+void z80_reset(Z80 *cpu)
+{
+	if (!tablesReady) initTables();
+	cpu->af.w = cpu->sp.w = 0xffff;
+	cpu->pc.w = 0;
+	cpu->i = cpu->r = 0;
+	cpu->iff1 = cpu->iff2 = false;
+	cpu->im = 0;
+	cpu->halted = cpu->eiDelay = false;
+	cpu->wz = 0;
+}
+
+/**
+ * Executes one instruction.
+ * @return T-states of the instruction.
+ */
+uint8_t z80_step(Z80 *cpu)
+{
+	uint8_t t = 0, op;
+	Z80Pair_t *xy = &cpu->hl;
+	bool indexed = false;
+
+	cpu->eiDelay = false;
+	if (cpu->halted) {
+		cpu->r = (cpu->r & 0x80) | ((cpu->r + 1) & 0x7f);
+		t = 4 + cpu->m1Wait;
+		cpu->tstates += t;
+		return t;
+	}
+
+	uint64_t start = cpu->tstates;
+	op = fetchOp(cpu);
+	while (op == 0xdd || op == 0xfd) {
+		xy = op == 0xdd ? &cpu->ix : &cpu->iy;
+		indexed = true;
+		op = fetchOp(cpu);
+		if (op == 0xdd || op == 0xfd) t += 4;					// Repeated prefixes act as NOPs
+	}
+
+	if (op == 0xed) {
+		t += (indexed ? 4 : 0) + execED(cpu, fetchOp(cpu));
+	} else if (op == 0xcb) {
+		if (indexed) {
+			uint16_t addr = xy->w + (int8_t)fetch8(cpu);
+			WZ = addr;
+			t += execCB(cpu, fetch8(cpu), addr, true);
+		} else {
+			t += execCB(cpu, fetchOp(cpu), HL, false);
+		}
+	} else {
+		t += exec(cpu, op, xy, indexed);
+	}
+
+	cpu->tstates += t;
+	return cpu->tstates - start;
+}
+
+/**
+ * Requests a maskable interrupt.
+ * @return True if the interrupt was accepted.
+ */
+bool z80_interrupt(Z80 *cpu, uint8_t data)
+{
+	if (!cpu->iff1 || cpu->eiDelay) return false;
+
+	cpu->halted = false;
+	cpu->iff1 = cpu->iff2 = false;
+	cpu->r = (cpu->r & 0x80) | ((cpu->r + 1) & 0x7f);
+	z80_push16(cpu, PC);
+	if (cpu->im == 2) {
+		PC = read16(cpu, (cpu->i << 8) | data);
+		cpu->tstates += 19;
+	} else {
+		PC = 0x0038;
+		cpu->tstates += 13;
+	}
+	WZ = PC;
+	if (cpu->m1Wait) cpu->tstates++;
+	return true;
+}
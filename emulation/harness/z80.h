@@ -0,0 +1,70 @@
+/*
+	Copyright (c) 2024 Natalia Pujol Cremades
+	info@abitwitches.com
+
+	See LICENSE file.
+
+	- - - - - - - - - - - - - - - - - - - - - - - -
+
+	Z80 core for the host harness.
+
+	Flat 64KB memory, I/O through callbacks, T-states counted per
+	instruction including the MSX M1 wait state.
+*/
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+
+// ========================================================
+// Defines
+
+#define Z80_FLAG_C		0x01
+#define Z80_FLAG_N		0x02
+#define Z80_FLAG_PV		0x04
+#define Z80_FLAG_X		0x08
+#define Z80_FLAG_H		0x10
+#define Z80_FLAG_Y		0x20
+#define Z80_FLAG_Z		0x40
+#define Z80_FLAG_S		0x80
+
+
+// ========================================================
+// Struct & Enums
+
+typedef union {
+	uint16_t w;
+	struct {
+		uint8_t l;						// Little-endian host
+		uint8_t h;
+	} b;
+} Z80Pair_t;
+
+typedef struct Z80 {
+	Z80Pair_t af, bc, de, hl;
+	Z80Pair_t af2, bc2, de2, hl2;
+	Z80Pair_t ix, iy, sp, pc;
+	uint16_t wz;
+	uint8_t  i, r;
+	bool     iff1, iff2;
+	uint8_t  im;
+	bool     halted;
+	bool     eiDelay;					// Interrupts are accepted after the instruction following EI
+	bool     m1Wait;					// MSX adds a wait state to each M1 cycle
+	uint64_t tstates;
+
+	uint8_t *mem;
+	void    *ctx;
+	uint8_t (*in)(void *ctx, uint16_t port);
+	void    (*out)(void *ctx, uint16_t port, uint8_t value);
+} Z80;
+
+
+// ========================================================
+// Functions
+
+void z80_reset(Z80 *cpu);
+uint8_t z80_step(Z80 *cpu);
+bool z80_interrupt(Z80 *cpu, uint8_t data);
+uint16_t z80_pop16(Z80 *cpu);
+void z80_push16(Z80 *cpu, uint16_t value);
@@ -53,20 +53,12 @@ namespace eval ocm_ioports {
 		79	0b11001100
 	}
 
-	# SX-E
-	set ioports_array(73) 0b01011000
-	set ioports_array(0)  0b00011000
-	set ioports_array(1)  0b01100000
-
-	# 3.9.1
-#	set ioports_array(78) 0b00100111
-#	set ioports_array(79) 0b10101011
-
-	# I/O 4
-#	set ioports_array(79) 0b10100100
-
-	# I/O 10
-#	set ioports_array(79) 0b10101010
+	# Machine presets (ocm_machines.txt): applied over the values above
+	variable machines_file [file join [file dirname [info script]] ocm_machines.txt]
+	variable machines
+	variable machine_names {}
+	variable machine ""
+	variable ioports_default [array get ioports_array]
 
 	variable cmd
 	array set cmd {
@@ -159,6 +151,87 @@ namespace eval ocm_ioports {
 		255 { 0 0 0 }
 	}
 
+	proc load_machines {} {
+		variable machines_file
+		variable machines
+		variable machine_names
+
+		set fh [open $machines_file r]
+		set machine_names {}
+		while {[gets $fh line] >= 0} {
+			set line [string trim $line]
+			if {$line eq "" || [string index $line 0] eq "#"} continue
+			set fields [regexp -all -inline {\S+} $line]
+			if {[llength $fields] < 5} {
+				close $fh
+				error "Bad machine preset in $machines_file: $line"
+			}
+			set name [lindex $fields 0]
+			set machines($name) [lrange $fields 1 end]
+			lappend machine_names $name
+		}
+		close $fh
+	}
+
+	proc sdram_bits {mb} {
+		switch -- $mb {
+			8  { return {0 0} }
+			16 { return {1 0} }
+			32 { return {2 0} }
+		}
+		if {$mb < 64 || $mb > 512 || $mb % 64} { error "Unsupported SDRAM size: $mb MB" }
+		return [list 3 [expr {$mb / 64 - 1}]]
+	}
+
+	proc apply_machine {name} {
+		variable machines
+		variable machine
+		variable ioports_array
+		variable ioports_default
+
+		if {![info exists machines($name)]} { error "Unknown OCM machine preset: $name" }
+		set overrides [lassign $machines($name) type iorev pld sdram]
+		lassign [split $pld .] major minor sub
+		if {$sub eq ""} { set sub 0 }
+		lassign [sdram_bits $sdram] size size_aux
+
+		array set ioports_array $ioports_default
+		set ioports_array(73) [expr {($ioports_array(73) & ~0x3c) | (($type & 0x0f) << 2)}]
+		set ioports_array(78) [expr {$major * 10 + $minor}]
+		set ioports_array(79) [expr {($ioports_array(79) & 0x80) | (($sub & 0x03) << 5) | ($iorev & 0x1f)}]
+		set ioports_array(0) [expr {($ioports_array(0) & ~0x18) | ($size << 3)}]
+		set ioports_array(1) [expr {($ioports_array(1) & ~0x0e) | ($size_aux << 1)}]
+		foreach override $overrides {
+			lassign [split $override =] port value
+			set ioports_array($port) [expr {$value}]
+		}
+		set machine $name
+	}
+
+	# ocm_machine         Lists the presets, the current one marked with '*'
+	# ocm_machine NAME    Selects a preset (the program reads it at its next start)
+	proc ocm_machine {{name ""}} {
+		variable machines
+		variable machine
+		variable machine_names
+
+		if {$name eq ""} {
+			set result ""
+			foreach preset $machine_names {
+				lassign $machines($preset) type iorev pld sdram
+				append result [format "%s %-14s type:%-2d I/O rev:%-2d PLD:%-6s SDRAM:%dMB\n" \
+					[expr {$preset eq $machine ? "*" : " "}] $preset $type $iorev $pld $sdram]
+			}
+			return $result
+		}
+		apply_machine $name
+		ocm_info_update
+		return "OCM machine preset: $name"
+	}
+
+	namespace export ocm_machine
+
+
 	proc ocm_ioports_start {} {
 		set watchpoint_id_write [debug set_watchpoint write_io 0x40 {} { ocm_ioports::trigger_id_write }]
 		set watchpoint_id_read [debug set_watchpoint read_io 0x40 {} { ocm_ioports::trigger_id_read }]
@@ -185,18 +258,24 @@ namespace eval ocm_ioports {
 	}
 
 	proc trigger_id_write {} {
+		trace_write 0x40 $::wp_last_value
 		set ocm_ioports::ioext_id $::wp_last_value
 		ocm_info_update
 	}
 
 	proc trigger_id_read {} {
+		set value 0xff
 		if {$ocm_ioports::ioext_id == 0xd4} {
-			set complement [expr {255 - 0xd4}]
-			after time 0 "reg a $complement"
+			set value [expr {255 - 0xd4}]
+		}
+		set value [trace_read 0x40 $value]
+		if {$value != 0xff} {
+			after time 0 "reg a $value"
 		}
 	}
 
 	proc trigger_smartcmd_write {} {
+		trace_write 0x41 $::wp_last_value
 		if {![info exists ocm_ioports::cmd($::wp_last_value)]} {
 			puts stderr [format "Error: Invalid smart command 0x%02X (%d)" $::wp_last_value $::wp_last_value]
 			return
@@ -212,35 +291,38 @@ namespace eval ocm_ioports {
 	}
 
 	proc trigger_smartcmd_read {} {
-		set value [expr { 255 - $ocm_ioports::port41}]
+		set value [trace_read 0x41 [expr { 255 - $ocm_ioports::port41}]]
 		after time 0 "reg a $value"
 	}
 
 	proc trigger_read {} {
 		set in_port [expr $::wp_last_address & 0xFF]
 		if {$in_port == 0x44} {
-			after time 0 "reg a $ocm_ioports::port4b_id"
+			set in_value $ocm_ioports::port4b_id
 		} else {
 			set in_value $ocm_ioports::ioports_array($in_port)
-			after time 0 "reg a $in_value"
 		}
+		set in_value [trace_read $in_port $in_value]
+		after time 0 "reg a $in_value"
 	}
 
 	proc trigger_write {} {
 		set in_port [expr $::wp_last_address & 0xFF]
+		trace_write $in_port $::wp_last_value
 		set in_value [expr {255 - $::wp_last_value}]
 		set ocm_ioports::ioports_array($in_port) $in_value
 		ocm_info_update
 	}
 
 	proc trigger_write44 {} {
+		trace_write 0x44 $::wp_last_value
 		set in_value [expr {255 - $::wp_last_value}]
 		set ocm_ioports::port4b_id $in_value
 		ocm_info_update
 	}
 
 	proc trigger_read4b {} {
-		set in_value $ocm_ioports::ioports_array($ocm_ioports::port4b_id)
+		set in_value [trace_read 0x4b $ocm_ioports::ioports_array($ocm_ioports::port4b_id)]
 		after time 0 "reg a $in_value"
 	}
 
@@ -249,6 +331,190 @@ namespace eval ocm_ioports {
 	namespace export ocm_ioports_stop
 
 
+	################################################################## Trace
+
+	# Binary trace file: "OCMT" + version byte, then 9 bytes records:
+	#   type(1) port(1) value(1) pc(2) time(4)    little-endian, time in usecs
+	# Types: 0 read, 1 write, 2 key taken from the BIOS buffer (value = key),
+	#        3 text mark (port = text length, the text follows the record)
+	#
+	# Recording starts with ocm_trace_record or the OCM_IOTRACE environment
+	# item. In replay mode (ocm_trace_replay or OCM_IOREPLAY) the reads answer
+	# the recorded values and the writes are checked against the trace; after
+	# the first divergence the normal port emulation is used again.
+
+	variable TRACE_MAGIC "OCMT"
+	variable TRACE_VERSION 1
+	variable TRACE_READ 0
+	variable TRACE_WRITE 1
+	variable TRACE_KEY 2
+	variable TRACE_MARK 3
+
+	variable KEYBUF		0xfbf0
+	variable KEYBUF_END	0xfc18
+	variable GETPNT		0xf3fa
+
+	variable trace_fh ""
+	variable trace_count 0
+	variable watchpoint_keys ""
+	variable replay_list {}
+	variable replay_pos 0
+	variable replay_diverged false
+
+	proc trace_record {type port value} {
+		variable trace_fh
+		variable trace_count
+		set pc [reg PC]
+		set usecs [expr {round([machine_info time] * 1000000) & 0xffffffff}]
+		puts -nonewline $trace_fh [binary format cccsi $type $port $value $pc $usecs]
+		incr trace_count
+	}
+
+	proc trace_divergence {type port value} {
+		variable replay_list
+		variable replay_pos
+		variable replay_diverged
+		set replay_diverged true
+		set expected [lindex $replay_list $replay_pos]
+		puts stderr [format "OCM trace replay diverged at access #%d PC=0x%04X: got %s 0x%02X=0x%02X, expected {%s}" \
+			$replay_pos [reg PC] [expr {$type ? "OUT" : "IN"}] $port $value $expected]
+	}
+
+	proc trace_read {port value} {
+		variable trace_fh
+		variable replay_list
+		variable replay_pos
+		variable replay_diverged
+		variable TRACE_READ
+
+		if {[llength $replay_list] && !$replay_diverged} {
+			lassign [lindex $replay_list $replay_pos] type rport rvalue
+			if {$type == $TRACE_READ && $rport == $port} {
+				set value $rvalue
+				incr replay_pos
+			} else {
+				trace_divergence $TRACE_READ $port $value
+			}
+		}
+		if {$trace_fh ne ""} { trace_record $TRACE_READ $port $value }
+		return $value
+	}
+
+	proc trace_write {port value} {
+		variable trace_fh
+		variable replay_list
+		variable replay_pos
+		variable replay_diverged
+		variable TRACE_WRITE
+
+		if {[llength $replay_list] && !$replay_diverged} {
+			lassign [lindex $replay_list $replay_pos] type rport rvalue
+			if {$type == $TRACE_WRITE && $rport == $port && $rvalue == $value} {
+				incr replay_pos
+			} else {
+				trace_divergence $TRACE_WRITE $port $value
+			}
+		}
+		if {$trace_fh ne ""} { trace_record $TRACE_WRITE $port $value }
+	}
+
+	proc trace_key {} {
+		variable trace_fh
+		variable KEYBUF
+		variable KEYBUF_END
+		variable TRACE_KEY
+
+		if {$trace_fh eq ""} return
+		# The watchpoint fires at the low byte write, before the high byte is
+		# updated: the buffer crosses a page (0xFBF0-0xFC17), so the high byte
+		# comes from the new low byte
+		set low $::wp_last_value
+		set get [expr {(($KEYBUF & 0xff00) + ($low < ($KEYBUF & 0xff) ? 0x100 : 0)) | $low}]
+		if {$get == $KEYBUF} { set get $KEYBUF_END }
+		trace_record $TRACE_KEY 0 [peek [expr {$get - 1}]]
+		flush $trace_fh
+	}
+
+	proc ocm_trace_record {file} {
+		variable trace_fh
+		variable trace_count
+		variable watchpoint_keys
+		variable TRACE_MAGIC
+		variable TRACE_VERSION
+		variable GETPNT
+
+		if {$trace_fh ne ""} { ocm_trace_stop }
+		set trace_fh [open $file w]
+		fconfigure $trace_fh -translation binary
+		puts -nonewline $trace_fh [binary format a4c $TRACE_MAGIC $TRACE_VERSION]
+		set trace_count 0
+		set watchpoint_keys [debug set_watchpoint write_mem $GETPNT {} { ocm_ioports::trace_key }]
+		return "Recording OCM I/O trace to $file"
+	}
+
+	proc ocm_trace_mark {text} {
+		variable trace_fh
+		variable TRACE_MARK
+
+		if {$trace_fh eq ""} return
+		set text [string range $text 0 254]
+		trace_record $TRACE_MARK [string length $text] 0
+		puts -nonewline $trace_fh $text
+		flush $trace_fh
+		return ""
+	}
+
+	proc ocm_trace_stop {} {
+		variable trace_fh
+		variable trace_count
+		variable watchpoint_keys
+
+		if {$trace_fh eq ""} { return "No OCM I/O trace is being recorded" }
+		close $trace_fh
+		set trace_fh ""
+		debug remove_watchpoint $watchpoint_keys
+		return "Stopped OCM I/O trace: $trace_count records"
+	}
+
+	proc ocm_trace_replay {file} {
+		variable replay_list
+		variable replay_pos
+		variable replay_diverged
+		variable TRACE_MAGIC
+		variable TRACE_READ
+		variable TRACE_WRITE
+		variable TRACE_MARK
+
+		set fh [open $file r]
+		fconfigure $fh -translation binary
+		set data [read $fh]
+		close $fh
+		if {[string range $data 0 3] ne $TRACE_MAGIC} {
+			error "$file is not an OCM I/O trace"
+		}
+
+		set replay_list {}
+		set pos 5
+		while {$pos + 9 <= [string length $data]} {
+			binary scan $data @${pos}cucucu type port value
+			incr pos 9
+			if {$type == $TRACE_READ || $type == $TRACE_WRITE} {
+				lappend replay_list [list $type $port $value]
+			} elseif {$type == $TRACE_MARK} {
+				incr pos $port
+			}
+		}
+		set replay_pos 0
+		set replay_diverged false
+		return "Replaying [llength $replay_list] OCM I/O accesses from $file"
+	}
+
+	namespace export ocm_trace_record
+	namespace export ocm_trace_mark
+	namespace export ocm_trace_stop
+	namespace export ocm_trace_replay
+
+
 	################################################################## Panel
 
 	variable info_active false
@@ -257,6 +523,8 @@ namespace eval ocm_ioports {
 	variable sub_panel_width 84
 	variable sub_panel_height [expr {$textheight + 1}]
 	variable panel_info
+	variable info_after ""
+	variable info_values
 
 	array set flaglabels {
 		64 "40h DeviceID"
@@ -279,6 +547,7 @@ namespace eval ocm_ioports {
 
 	proc ocm_info_init {} {
 		variable flaglabels
+		variable info_values
 		variable info_active
 		variable textheight
 		variable panel_margin
@@ -335,7 +604,8 @@ namespace eval ocm_ioports {
 							[dict get $info row]
 		}
 
-		ocm_info_update
+		array unset info_values
+		ocm_info_refresh
 	}
 
 	proc create_sub_panel {name title num color width row} {
@@ -371,31 +641,52 @@ namespace eval ocm_ioports {
 		return [format %08b $ocm_ioports::ioports_array($num)]
 	}
 
+	# The port triggers only mark the panel as dirty: the OSD widgets are
+	# refreshed once per frame, and only those whose value changed
 	proc ocm_info_update {} {
 		variable info_active
+		variable info_after
+
+		if {$info_active && $info_after eq ""} {
+			set info_after [after frame ocm_ioports::ocm_info_refresh]
+		}
+		return $info_active
+	}
+
+	proc ocm_info_refresh {} {
+		variable info_active
+		variable info_after
+		variable info_values
 		variable panel_info
 
-		if {$info_active} {
-			dict for {name info} $panel_info {
-				set num [dict get $info num]
-				if {$num!=""} {
-					if {$num==64} {
-						set value $ocm_ioports::ioext_id
-					} else {
-						set value [get_flag $num]
-					}
+		set info_after ""
+		if {!$info_active} return
+		dict for {name info} $panel_info {
+			set num [dict get $info num]
+			if {$num!=""} {
+				if {$num==64} {
+					set value $ocm_ioports::ioext_id
+				} else {
+					set value [get_flag $num]
+				}
+				if {![info exists info_values($name)] || $info_values($name) ne $value} {
 					osd configure info.$name.value -text $value
+					set info_values($name) $value
 				}
 			}
 		}
-		return $info_active
 	}
 
 	proc ocm_toggle_info {} {
 		variable info_active
+		variable info_after
 
 		if {$info_active} {
 			set info_active false
+			if {$info_after ne ""} {
+				after cancel $info_after
+				set info_after ""
+			}
 			osd destroy info
 		} else {
 			set info_active true
@@ -414,5 +705,13 @@ namespace eval ocm_ioports {
 namespace import ocm_ioports::*
 
 
+ocm_ioports::load_machines
+if {[info exists ::env(OCM_MACHINE)] && $::env(OCM_MACHINE) ne ""} {
+	ocm_ioports::apply_machine $::env(OCM_MACHINE)
+} else {
+	ocm_ioports::apply_machine [lindex $ocm_ioports::machine_names 0]
+}
 ocm_ioports_start
+if {[info exists ::env(OCM_IOREPLAY)] && $::env(OCM_IOREPLAY) ne ""} { ocm_trace_replay $::env(OCM_IOREPLAY) }
+if {[info exists ::env(OCM_IOTRACE)] && $::env(OCM_IOTRACE) ne ""} { ocm_trace_record $::env(OCM_IOTRACE) }
 #ocm_toggle_info
\ No newline at end of file
@@ -0,0 +1,131 @@
+# Collector of the PERF_BEGIN/PERF_END zone markers (includes/perf.h)
+#
+# The program writes the PERF_MODE byte to the debugdevice mode port (0x2e)
+# and the zone id to the data port (0x2f), with bit 7 set at the zone end.
+# Each zone is timed with the emulated time, so the figures are exact and
+# do not depend on the host speed.
+#
+# Commands:
+#   perf_report   Show calls, total, average & max time of each zone
+#   perf_reset    Clear the collected times
+
+namespace eval perf {
+
+	variable z80_clock 3579545
+	variable PERF_MODE 0x60
+	variable PERF_ENDFLAG 0x80
+
+	variable zone_names
+	array set zone_names {
+		1 getOcmData
+		2 drawElement
+		3 showDialog
+		4 loadProfiles
+		5 stringsInit
+	}
+
+	variable mode 0
+	variable begin_stack
+	variable calls
+	variable total
+	variable max
+	array set begin_stack {}
+	array set calls {}
+	array set total {}
+	array set max {}
+
+	variable watchpoint_mode
+	variable watchpoint_data
+
+	proc on_mode {} {
+		variable mode
+		set mode $::wp_last_value
+	}
+
+	proc on_data {} {
+		variable mode
+		variable PERF_MODE
+		variable PERF_ENDFLAG
+		variable begin_stack
+		variable calls
+		variable total
+		variable max
+
+		if {$mode != $PERF_MODE} return
+		set now [machine_info time]
+		set zone [expr {$::wp_last_value & ~$PERF_ENDFLAG & 0xff}]
+
+		if {!($::wp_last_value & $PERF_ENDFLAG)} {
+			lappend begin_stack($zone) $now
+			return
+		}
+		if {![info exists begin_stack($zone)] || ![llength $begin_stack($zone)]} return
+
+		set start [lindex $begin_stack($zone) end]
+		set begin_stack($zone) [lrange $begin_stack($zone) 0 end-1]
+		set elapsed [expr {$now - $start}]
+		if {![info exists calls($zone)]} {
+			set calls($zone) 0
+			set total($zone) 0.0
+			set max($zone) 0.0
+		}
+		incr calls($zone)
+		set total($zone) [expr {$total($zone) + $elapsed}]
+		if {$elapsed > $max($zone)} { set max($zone) $elapsed }
+	}
+
+	proc zone_name {zone} {
+		variable zone_names
+		if {[info exists zone_names($zone)]} { return $zone_names($zone) }
+		return "zone$zone"
+	}
+
+	proc perf_report {} {
+		variable z80_clock
+		variable calls
+		variable total
+		variable max
+
+		set result [format "%-14s %8s %12s %10s %10s %12s\n" \
+			"Zone" "Calls" "Total us" "Avg us" "Max us" "Avg T"]
+		foreach zone [lsort -integer [array names calls]] {
+			set avg [expr {$total($zone) / $calls($zone)}]
+			append result [format "%-14s %8d %12.0f %10.0f %10.0f %12.0f\n" \
+				[zone_name $zone] $calls($zone) \
+				[expr {$total($zone) * 1000000}] \
+				[expr {$avg * 1000000}] \
+				[expr {$max($zone) * 1000000}] \
+				[expr {$avg * $z80_clock}]]
+		}
+		return $result
+	}
+
+	proc perf_reset {} {
+		variable begin_stack
+		variable calls
+		variable total
+		variable max
+
+		array unset begin_stack
+		array unset calls
+		array unset total
+		array unset max
+		return ""
+	}
+
+	proc perf_start {} {
+		variable watchpoint_mode
+		variable watchpoint_data
+
+		set watchpoint_mode [debug set_watchpoint write_io 0x2e {} {perf::on_mode}]
+		set watchpoint_data [debug set_watchpoint write_io 0x2f {} {perf::on_data}]
+	}
+
+	namespace export perf_report
+	namespace export perf_reset
+
+} ; #namespace
+
+namespace import perf::*
+
+perf::perf_start
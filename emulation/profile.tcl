@@ -0,0 +1,239 @@
+# Sampling profiler of OCMINFO.COM (used by 'make profile', after bench.tcl)
+#
+# Environment:
+#   PROFILE_SCENARIO   Bench scenario to profile (default: all of them)
+#   PROFILE_INTERVAL   Sampling interval in emulated microseconds (default: 50)
+#   PROFILE_MAP        Linker map file of the program (default: obj/ocminfo.map)
+#   PROFILE_OUT        Report file (default: profile.txt)
+#   BENCH_NOI          NoICE symbols file, for symbols missing in the map
+#
+# The bench.tcl scenarios drive the program; while the selected scenario
+# runs, the Z80 PC is sampled every PROFILE_INTERVAL of emulated time and
+# assigned to the nearest symbol below it. Samples with a ROM selected in
+# the page of the PC (BIOS calls, interrupts...) go to [BIOS] or
+# [DOS/system] instead, as they share addresses with the program. The
+# report has a flat profile by function and a summary by module.
+
+namespace eval profile {
+
+	variable scenario ""
+	variable interval 50
+	variable map_file "obj/ocminfo.map"
+	variable noi_file "obj/ocminfo.noi"
+	variable out_file "profile.txt"
+	variable top 40
+
+	variable addrs {}					;# Sorted symbol addresses
+	variable names {}					;# Symbol name at each address
+	variable modules {}					;# Module of each symbol
+	variable code_start 0x10000
+	variable code_end 0
+
+	variable active false
+	variable total 0
+	variable by_symbol
+	array set by_symbol {}
+
+	# Map lines: "     00000195  _main                              ocminfo"
+	proc read_map {file symbols_var} {
+		upvar $symbols_var symbols
+		if {![file exists $file]} return
+		set fh [open $file r]
+		while {[gets $fh line] >= 0} {
+			if {[regexp {^\s*([0-9A-Fa-f]{4,8})\s+(\S+)\s+(\S+)\s*$} $line -> addr name module]} {
+				set symbols($name) [list [scan $addr %x] $module]
+			}
+		}
+		close $fh
+	}
+
+	# NoICE lines: "DEF _main 0x195"
+	proc read_noi {file symbols_var} {
+		upvar $symbols_var symbols
+		if {![file exists $file]} return
+		set fh [open $file r]
+		while {[gets $fh line] >= 0} {
+			if {[lindex $line 0] eq "DEF" && ![info exists symbols([lindex $line 1])]} {
+				set symbols([lindex $line 1]) [list [expr {[lindex $line 2] + 0}] "?"]
+			}
+		}
+		close $fh
+	}
+
+	proc load_symbols {} {
+		variable map_file
+		variable noi_file
+		variable addrs
+		variable names
+		variable modules
+		variable code_start
+		variable code_end
+
+		array set symbols {}
+		read_map $map_file symbols
+		read_noi $noi_file symbols
+
+		set list {}
+		foreach name [array names symbols] {
+			lassign $symbols($name) addr module
+			# Area limits & sizes are not code
+			if {[string match "s__*" $name] || [string match "l__*" $name]} {
+				if {$name eq "s__DATA"} { set code_end $addr }
+				continue
+			}
+			if {$addr < 0x100} continue
+			lappend list [list $addr $name $module]
+		}
+		set list [lsort -integer -index 0 $list]
+		foreach item $list {
+			lappend addrs [lindex $item 0]
+			lappend names [lindex $item 1]
+			lappend modules [lindex $item 2]
+		}
+		if {[llength $addrs]} {
+			set code_start [lindex $addrs 0]
+			if {!$code_end} { set code_end [expr {[lindex $addrs end] + 0x100}] }
+		}
+		return [llength $addrs]
+	}
+
+	# Index of the last symbol at or below addr
+	proc find_symbol {addr} {
+		variable addrs
+		set lo 0
+		set hi [expr {[llength $addrs] - 1}]
+		while {$lo < $hi} {
+			set mid [expr {($lo + $hi + 1) / 2}]
+			if {[lindex $addrs $mid] <= $addr} { set lo $mid } else { set hi [expr {$mid - 1}] }
+		}
+		return $lo
+	}
+
+	# Under MSX-DOS the program runs from the RAM slot that page 3 always has
+	proc in_ram {addr} {
+		expr {[get_selected_slot [expr {$addr >> 14}]] eq [get_selected_slot 3]}
+	}
+
+	proc sample {} {
+		variable active
+		variable interval
+		variable total
+		variable by_symbol
+		variable code_start
+		variable code_end
+
+		if {$active} {
+			set pc [reg PC]
+			if {![in_ram $pc]} {
+				set key [expr {$pc < 0x4000 ? "\[BIOS\]" : "\[DOS/system\]"}]
+			} elseif {$pc < $code_start || $pc >= $code_end} {
+				set key "\[DOS/system\]"
+			} else {
+				set key [find_symbol $pc]
+			}
+			if {[info exists by_symbol($key)]} { incr by_symbol($key) } else { set by_symbol($key) 1 }
+			incr total
+		}
+		after time [expr {$interval / 1000000.0}] profile::sample
+	}
+
+	proc on_begin {name} {
+		variable active
+		variable scenario
+		if {$scenario eq "" || $scenario eq $name} { set active true }
+	}
+
+	proc on_end {name} {
+		variable active
+		set active false
+	}
+
+	proc percent {count} {
+		variable total
+		if {!$total} { return 0.0 }
+		return [expr {$count * 100.0 / $total}]
+	}
+
+	proc report {} {
+		variable scenario
+		variable interval
+		variable total
+		variable top
+		variable by_symbol
+		variable names
+		variable modules
+
+		set rows {}
+		array set by_module {}
+		foreach key [array names by_symbol] {
+			if {[string is integer $key]} {
+				set name [lindex $names $key]
+				set module [lindex $modules $key]
+			} else {
+				set name $key
+				set module $key
+			}
+			lappend rows [list $by_symbol($key) $name $module]
+			if {[info exists by_module($module)]} {
+				incr by_module($module) $by_symbol($key)
+			} else {
+				set by_module($module) $by_symbol($key)
+			}
+		}
+
+		set title [expr {$scenario eq "" ? "all scenarios" : $scenario}]
+		set result "Profile of $title: $total samples every ${interval}us\n\n"
+		append result [format "%8s %7s %7s  %-32s %s\n" "Samples" "%" "Cum%" "Function" "Module"]
+		set cumul 0.0
+		set shown 0
+		foreach row [lsort -integer -decreasing -index 0 $rows] {
+			lassign $row count name module
+			set cumul [expr {$cumul + [percent $count]}]
+			if {[incr shown] > $top} break
+			append result [format "%8d %6.2f%% %6.2f%%  %-32s %s\n" $count [percent $count] $cumul $name $module]
+		}
+
+		append result "\n" [format "%8s %7s  %s\n" "Samples" "%" "Module"]
+		set list {}
+		foreach module [array names by_module] { lappend list [list $by_module($module) $module] }
+		foreach row [lsort -integer -decreasing -index 0 $list] {
+			lassign $row count module
+			append result [format "%8d %6.2f%%  %s\n" $count [percent $count] $module]
+		}
+		return $result
+	}
+
+	proc on_finish {} {
+		variable out_file
+		set fh [open $out_file w]
+		puts -nonewline $fh [report]
+		close $fh
+	}
+
+	proc profile_start {} {
+		variable scenario
+		variable interval
+		variable map_file
+		variable noi_file
+		variable out_file
+
+		if {[info exists ::env(PROFILE_SCENARIO)]} { set scenario $::env(PROFILE_SCENARIO) }
+		if {[info exists ::env(PROFILE_INTERVAL)] && $::env(PROFILE_INTERVAL) ne ""} { set interval $::env(PROFILE_INTERVAL) }
+		if {[info exists ::env(PROFILE_MAP)]} { set map_file $::env(PROFILE_MAP) }
+		if {[info exists ::env(BENCH_NOI)]} { set noi_file $::env(BENCH_NOI) }
+		if {[info exists ::env(PROFILE_OUT)]} { set out_file $::env(PROFILE_OUT) }
+
+		if {![load_symbols]} {
+			puts stderr "profile: no symbols found in $map_file or $noi_file"
+			exit 1
+		}
+
+		bench::add_hook begin profile::on_begin
+		bench::add_hook end profile::on_end
+		bench::add_hook finish profile::on_finish
+		sample
+	}
+
+} ; #namespace
+
+profile::profile_start
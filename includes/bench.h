@@ -0,0 +1,20 @@
+/*
+	Copyright (c) 2024 Natalia Pujol Cremades
+	info@abitwitches.com
+
+	See LICENSE file.
+
+	- - - - - - - - - - - - - - - - - - - - - - - -
+
+	Common helpers of the built-in benchmarks (bench_*.c), all timed in
+	frames with the JIFFY counter.
+*/
+#pragma once
+#include <stdint.h>
+#include "msx_const.h"
+
+
+// ========================================================
+// Defines
+
+#define BENCH_FRAMERATE()		(varRG9SAV & 0b00000010 ? 50 : 60)	// VDP R#9 NT/PAL bit
@@ -0,0 +1,39 @@
+/*
+	Copyright (c) 2024 Natalia Pujol Cremades
+	info@abitwitches.com
+
+	See LICENSE file.
+
+	- - - - - - - - - - - - - - - - - - - - - - - -
+
+	CPU throughput benchmark: runs a calibrated Z80 loop timed against the
+	VDP interrupt (JIFFY) and reports the effective speed of the current CPU
+	setting, or of every standard/custom speed.
+*/
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+
+// ========================================================
+// Defines & structs
+
+#define BENCHCPU_FRAMES			8		// Frames measured for each speed
+#define BENCHCPU_LOOP_TSTATES	31		// T-states of a loop iteration (MSX M1 wait included)
+#define BENCHCPU_SPEEDS			8		// 3.58MHz + the 7 custom speeds
+
+typedef struct {
+	uint8_t  cmd;						// Smart command of the measured speed setting
+	uint16_t mhz100;					// Effective speed (1/100 MHz)
+	uint16_t ratio100;					// Ratio vs 3.58 MHz (1/100)
+} BenchCpu_t;
+
+
+// ========================================================
+// Functions
+
+uint8_t bench_cpuCurrentCmd();
+void bench_cpuMeasure(BenchCpu_t *result);
+void bench_cpuSweep(BenchCpu_t *results);
+char *bench_cpuSpeedName(uint8_t cmd);
+void bench_cpuFormat(char *str, BenchCpu_t *result);
@@ -0,0 +1,42 @@
+/*
+	Copyright (c) 2024 Natalia Pujol Cremades
+	info@abitwitches.com
+
+	See LICENSE file.
+
+	- - - - - - - - - - - - - - - - - - - - - - - -
+
+	Disk throughput benchmark: sequential write and read of a temporary file
+	and random 512 bytes reads over it, with the DOS2 file functions.
+	The file is created in the current directory, or at the path given by
+	the OCMINFO_BENCH environment item (i.e. a MegaSD partition).
+*/
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+
+// ========================================================
+// Defines & structs
+
+#define BENCHDISK_SIZE_DEFAULT	128		// Temporary file size (KB)
+#define BENCHDISK_SIZE_MAX		1024	// Max temporary file size (KB)
+#define BENCHDISK_CHUNK			4096	// Bytes written/read at once
+#define BENCHDISK_RANDOM		64		// Random reads done
+#define BENCHDISK_RANDOMSIZE	512		// Bytes of each random read
+
+typedef struct {
+	uint8_t  turboMegaSD;				// Turbo MegaSD state while measuring
+	uint8_t  error;						// DOS2 error code (0: no error)
+	uint16_t writeKBs;					// Sequential write (KB/s)
+	uint16_t readKBs;					// Sequential read (KB/s)
+	uint16_t randomRps;					// Random reads per second
+} BenchDisk_t;
+
+
+// ========================================================
+// Functions
+
+void bench_diskRun(BenchDisk_t *result, uint16_t sizeKB);
+void bench_diskSweep(BenchDisk_t *results, uint16_t sizeKB);
+void bench_diskFormat(char *str, BenchDisk_t *result);
@@ -0,0 +1,48 @@
+/*
+	Copyright (c) 2024 Natalia Pujol Cremades
+	info@abitwitches.com
+
+	See LICENSE file.
+
+	- - - - - - - - - - - - - - - - - - - - - - - -
+
+	Memory mapper benchmark and RAM check: allocates all the free segments of
+	the primary mapper with the DOS2 mapper support routines (including the
+	4MB extra mapper when it is enabled), writes a pattern in all of them and
+	verifies it, and measures the LDIR bandwidth inside a segment and the
+	segment switching speed with the mapper port 0xFE (page 2).
+*/
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+
+// ========================================================
+// Defines & structs
+
+#define BENCHMAP_FRAMES			16		// Frames measured for the LDIR and switching tests
+#define BENCHMAP_LDIRSIZE		1024	// Bytes copied by each LDIR
+#define BENCHMAP_PATTERN		(256+64)// Pattern bytes: a 256 bytes block for each of the 64 segment blocks
+
+#define BENCHMAP_ERR_NONE		0
+#define BENCHMAP_ERR_NOSUPPORT	1		// No DOS2 mapper support routines
+#define BENCHMAP_ERR_PAGE2		2		// The program code or the stack are in page 2
+#define BENCHMAP_ERR_NOFREE		3		// No free segments
+#define BENCHMAP_ERR_NORAM		4		// Not enough memory to run it
+
+typedef struct {
+	uint8_t  error;						// BENCHMAP_ERR_xxx
+	uint16_t totalKB;					// Primary mapper size (KB)
+	uint16_t freeKB;					// Free segments tested (KB)
+	uint16_t verifiedKB;				// Segments that passed the pattern check (KB)
+	uint16_t checkKBs;					// Pattern write+verify speed (KB/s)
+	uint16_t ldirKBs;					// LDIR bandwidth inside a segment (KB/s)
+	uint16_t switchK10;					// Segment switches per second (thousands x10)
+} BenchMapper_t;
+
+
+// ========================================================
+// Functions
+
+bool bench_mapperRun(BenchMapper_t *result);
+void bench_mapperFormat(char *str, BenchMapper_t *result);
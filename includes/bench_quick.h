@@ -0,0 +1,30 @@
+/*
+	Copyright (c) 2024 Natalia Pujol Cremades
+	info@abitwitches.com
+
+	See LICENSE file.
+
+	- - - - - - - - - - - - - - - - - - - - - - - -
+
+	Quick benchmark stored with the profiles: effective CPU speed, disk
+	sequential read and VRAM write, measured without leaving the text mode.
+*/
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "profiles_api.h"
+
+
+// ========================================================
+// Defines
+
+#define BENCHQUICK_DISKSIZE		32		// Temporary file size (KB)
+#define BENCHQUICK_LEN			24		// Max formatted results length
+#define BENCHQUICK_MAXMHZ100	9999	// CPU speed shown clamped to 2 integer digits
+
+
+// ========================================================
+// Functions
+
+void bench_quickRun(ProfileBench_t *bench);
+void bench_quickFormat(char *str, ProfileBench_t *bench);
@@ -0,0 +1,55 @@
+/*
+	Copyright (c) 2024 Natalia Pujol Cremades
+	info@abitwitches.com
+
+	See LICENSE file.
+
+	- - - - - - - - - - - - - - - - - - - - - - - -
+
+	CPU speed auto-tune: runs a deterministic checksum workload (CPU, RAM and
+	optionally the page 1 ROM of some slots, i.e. the external cartridges)
+	at 3.58MHz as reference, and then at each custom speed from 4.10MHz up.
+	The fastest stable speed is the last one whose checksums are identical
+	to the reference in all the runs; the speeds above the first failure
+	are not tested.
+*/
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+
+// ========================================================
+// Defines & structs
+
+#define BENCHTUNE_SPEEDS		7		// Custom speeds: 4.10MHz to 8.06MHz
+#define BENCHTUNE_RUNS			3		// Workload runs at each speed
+#define BENCHTUNE_CPULOOPS		512		// Arithmetic workload iterations
+#define BENCHTUNE_RAMSIZE		2048	// RAM workload buffer size
+#define BENCHTUNE_ROMSTART		0x4000	// Slot region read (page 1)
+#define BENCHTUNE_ROMSIZE		2048
+
+#define TUNE_SKIPPED			0
+#define TUNE_PASS				1
+#define TUNE_FAIL				2
+
+typedef struct {
+	uint16_t cpu;						// Arithmetic workload checksum
+	uint16_t ram;						// RAM workload checksum
+	uint16_t rom;						// Slots region checksum (0 if no slots)
+} BenchTuneSum_t;
+
+typedef struct {
+	uint8_t  slotMask;					// Primary slots read (bit N: slot N)
+	uint8_t  bestCmd;					// Fastest stable speed command (0: none)
+	uint8_t  status[BENCHTUNE_SPEEDS];	// TUNE_xxx of each custom speed
+	BenchTuneSum_t reference;			// 3.58MHz checksums
+} BenchTune_t;
+
+
+// ========================================================
+// Functions
+
+bool bench_tuneRun(BenchTune_t *result, uint8_t slotMask);
+uint16_t bench_tuneSaveProfile(BenchTune_t *result);
+void bench_tuneFormat(char *str, BenchTune_t *result, uint8_t index);
+void bench_tuneFormatBest(char *str, BenchTune_t *result);
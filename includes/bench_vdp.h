@@ -0,0 +1,40 @@
+/*
+	Copyright (c) 2024 Natalia Pujol Cremades
+	info@abitwitches.com
+
+	See LICENSE file.
+
+	- - - - - - - - - - - - - - - - - - - - - - - -
+
+	VDP throughput benchmark: VRAM write/read through the ports 0x98/0x99
+	and HMMV/HMMM/LMMM command engine speed, measured in a temporary SCREEN 8
+	(one byte per pixel). The caller must redraw its screen afterwards: the
+	original text mode is set again, but the VRAM contents are lost.
+*/
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+
+// ========================================================
+// Defines & structs
+
+#define BENCHVDP_FRAMES			16		// Frames measured for each test
+
+typedef struct {
+	uint8_t  vdpFast;					// VDP Fast mode while measuring
+	uint16_t vramWrite;					// VRAM write (Kpixels/s)
+	uint16_t vramRead;					// VRAM read (Kpixels/s)
+	uint16_t hmmv;						// HMMV fill (Kpixels/s)
+	uint16_t hmmm;						// HMMM copy (Kpixels/s)
+	uint16_t lmmm;						// LMMM logical copy (Kpixels/s)
+} BenchVdp_t;
+
+
+// ========================================================
+// Functions
+
+bool bench_vdpRun(BenchVdp_t *result);
+bool bench_vdpSweep(BenchVdp_t *results);
+uint16_t bench_vdpVramWrite();
+void bench_vdpFormat(char *str, BenchVdp_t *result);
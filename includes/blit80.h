@@ -0,0 +1,44 @@
+/*
+	Copyright (c) 2024 Natalia Pujol Cremades
+	info@abitwitches.com
+
+	See LICENSE file.
+
+	- - - - - - - - - - - - - - - - - - - - - - - -
+
+	Text output for SCREEN 0 width 80 (TEXT2) written directly to the VDP
+	ports: the rows VRAM addresses come from precomputed tables, and the
+	characters are sent with an unrolled OUTI chain entered at the point
+	that leaves exactly the needed OUTIs. Full width rectangles are
+	contiguous in VRAM, so they set the VRAM address only once.
+
+	The blink spans write the whole blink bytes directly, and only the
+	partial bytes at both ends are read, modified and written back.
+
+	Coordinates are 1 based as in conio, and the functions are drop-in
+	replacements of putlinexy, puttext, gettext and textblink.
+*/
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+
+// ========================================================
+// Defines
+
+#define BLIT80_WIDTH			80
+#define BLIT80_ROWS				24
+#define BLIT80_NAMETABLE		0x0000		// Characters: 80 bytes per row
+#define BLIT80_BLINKTABLE		0x0800		// Blink: 10 bytes per row (1 bit per char, MSB first)
+#define VRAM_WRITE				0x4000		// VRAM address flag to write
+
+
+// ========================================================
+// Functions
+
+void blit80_setVramAddress(uint16_t address) __z88dk_fastcall;
+void blit80_putvram(uint16_t vram, uint8_t length, void *source);
+void blit80_putline(uint8_t x, uint8_t y, uint16_t length, void *source);
+void blit80_puttext(uint8_t left, uint8_t top, uint8_t right, uint8_t bottom, void *source);
+void blit80_gettext(uint8_t left, uint8_t top, uint8_t right, uint8_t bottom, void *target);
+void blit80_blink(uint8_t x, uint8_t y, uint8_t length, bool enabled);
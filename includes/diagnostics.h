@@ -0,0 +1,43 @@
+/*
+	Copyright (c) 2024 Natalia Pujol Cremades
+	info@abitwitches.com
+
+	See LICENSE file.
+
+	- - - - - - - - - - - - - - - - - - - - - - - -
+
+	Runtime counters shown by the hidden diagnostics panel ('D' key), to
+	check the program performance on real hardware.
+*/
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+
+// ========================================================
+// Counters
+
+enum {
+	DIAG_PORTREADS = 0,					// OCM port reads since start (incremented from ocm_ioports.c asm: keep first)
+	DIAG_SMARTCMDS,						// OCM smart commands sent since start (idem: keep second)
+	DIAG_PANELFRAMES,					// Frames spent in the last panel switch
+	DIAG_REDRAWFRAMES,					// Frames spent in the last panel redraw
+	DIAG_OVERRUNS,						// Idle loop frames that took more than one VBLANK
+	DIAG_HEAPUSED,						// Heap bytes in use
+	DIAG_HEAPPEAK,						// Heap peak bytes in use
+	DIAG_HEAPFREE,						// Bytes left up to varTPALIMIT
+	DIAG_STRINGS,						// String table bytes resident in the heap
+	DIAG_PROFLOAD,						// Profiles file load time (JIFFY ticks)
+	DIAG_COUNT
+};
+
+extern uint16_t diag_values[DIAG_COUNT];
+
+
+// ========================================================
+// Functions
+
+void diag_init();
+void diag_idleBegin();
+void diag_idleFrame();
+void diag_update();
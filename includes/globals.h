@@ -9,4 +9,4 @@
 
 #define ARRAYEND				-1
 
-#define MAX_PROFILES	50
+#define MAX_PROFILES	300
@@ -16,6 +16,7 @@
 
 
 extern uint8_t *heap_top;
+extern uint8_t *heap_peak;					// Highest heap_top reached (diagnostics)
 
 extern void *malloc(uint16_t size);
 extern void free(uint16_t size);
@@ -174,6 +174,7 @@ __sfr __at (0x99) IO_VDP2;
 #define H_NMI		0xfdd6	// (...) At the beginning of non-maskable interrupts routine (Main-ROM at 0066h)
 #define EXTBIO		0xffca	// (...) Extended BIOS call
 #define RG8SAV		0xffe7	// (BYTE) Mirror Of VDP Register 8 (R#8)
+#define RG9SAV		0xffe8	// (BYTE) Mirror Of VDP Register 9 (R#9)
 
 // MSX-DOS system variables
 
@@ -191,6 +192,8 @@ volatile __at (PUTPNT) uint16_t varPUTPNT;
 volatile __at (GETPNT) uint16_t varGETPNT;
 volatile __at (MODE)   uint8_t  varMODE;
 volatile __at (JIFFY)  uint16_t varJIFFY;
+volatile __at (RG9SAV) uint8_t  varRG9SAV;
+volatile __at (EXPTBL) uint8_t  varEXPTBL[4];
 volatile __at (H_TIMI) uint16_t varHTIMI;
 volatile __at (FORCLR) uint16_t varFORCLR;
 volatile __at (BAKCLR) uint16_t varBAKCLR;
@@ -0,0 +1,49 @@
+/*
+	Copyright (c) 2024 Natalia Pujol Cremades
+	info@abitwitches.com
+
+	See LICENSE file.
+
+	- - - - - - - - - - - - - - - - - - - - - - - -
+
+	Performance zone markers for the openMSX debugdevice.
+
+	Enabled with _DEBUG_ or _PERF_ (make perf), each marker is two OUTs:
+	the PERF_MODE byte to the mode port and the zone id (bit 7 set at the
+	end of the zone) to the data port. emulation/perf.tcl collects them.
+	Release builds compile them to nothing.
+*/
+#pragma once
+#include <stdint.h>
+
+
+// ========================================================
+// Zones
+
+#define PERF_GETOCMDATA		1
+#define PERF_DRAWELEMENT	2
+#define PERF_SHOWDIALOG		3
+#define PERF_LOADPROFILES	4
+#define PERF_STRINGSINIT	5
+
+
+// ========================================================
+// Markers
+
+#if defined(_DEBUG_) || defined(_PERF_)
+
+	#define PERF_MODE		0b01100000		// No linefeed | multibyte | hexadecimal
+	#define PERF_ENDFLAG	0x80
+
+	__sfr __at (0x2e) IO_DEBUG_MODE;
+	__sfr __at (0x2f) IO_DEBUG_DATA;
+
+	#define PERF_BEGIN(id)	{ IO_DEBUG_MODE = PERF_MODE; IO_DEBUG_DATA = (id); }
+	#define PERF_END(id)	{ IO_DEBUG_MODE = PERF_MODE; IO_DEBUG_DATA = (id) | PERF_ENDFLAG; }
+
+#else
+
+	#define PERF_BEGIN(id)
+	#define PERF_END(id)
+
+#endif
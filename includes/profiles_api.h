@@ -10,10 +10,30 @@
 
 	--- ProfileHeader_t
 	--- ProfileHeaderData_t
-	--- ProfileItem_t 0
-	--- ProfileItem_t 1
+	--- uint16_t order[orderLength]		(only itemsCount entries are used)
+	--- ProfileItem_t slot 0
+	--- ProfileItem_t slot 1
 		...
-	--- ProfileItem_t n
+	--- ProfileItem_t slot n			(n = slotsCount-1)
+
+	Profile records are never moved to reorder the list: the 'order' array
+	holds the record slot shown at each list position. Slots not referenced
+	by the order array are free, and are reused by new records.
+
+	Only the header, the order array, a prefix index of the descriptions and
+	a small cache of records are kept in memory; records are read and written
+	by seeking into the file.
+	A modified record is always written to a free slot (copy on write), so
+	the file keeps its last saved contents until profile_saveFile().
+
+	The file path is taken from the OCMINFO environment item, or defaults to
+	the boot drive root. If OCMINFO_MIRROR is set (i.e. SET OCMINFO_MIRROR=
+	H:\OCMINFO.CFG) the file is copied there at first use and all the reads
+	and writes use the copy; profile_saveFile() then copies it back.
+
+	The latest quick benchmark results of each profile are kept in the
+	versioned ProfileBench_t struct, inside the former reserved bytes of
+	ProfileItem_t: records of older files have them zeroed (no results).
 
 */
 #pragma once
@@ -25,8 +45,20 @@
 // Defines
 
 #define PROF_MAGIC		{ 0x464f5250 }	//"PROF"
-#define PROF_REV		2
+#define PROF_REV		4
+#define PROF_REV_ORDER	3				// First revision storing the order array
+#define PROF_REV_PAGED	4				// First revision with paged records
 #define PROF_CMDSIZE	40
+#define PROF_RESERVED	24				// ProfileItem_t bytes after the commands
+#define PROF_BENCH_REV	1				// Current ProfileBench_t revision (0: no results)
+
+#define PROF_MAX_SLOTS	(MAX_PROFILES + 48)	// Profiles + copy on write slots until save
+#define PROF_CACHE_SIZE	20				// Records in memory: list window (15) + margin
+#define PROF_SORTKEY	8				// Description chars used as sort key
+#define PROF_INDEXKEY	4				// Description chars kept in the prefix index
+
+#define PROF_PATHLEN	65				// DOS2 max path + 1
+#define PROF_NOITEM		0xffff
 
 
 // ========================================================
@@ -36,35 +68,61 @@ typedef struct {
 	uint32_t magic;					// "PROF_MAGIC" chars
 	uint8_t  revision;				// Current Profiles file revision (PROF_REV)
 	uint16_t headerLength;			// SizeOf(ProfileHeaderData)
-	uint8_t  checksum;				// HeaderData + Items checksum
+	uint8_t  checksum;				// HeaderData + Order + Items checksum
 } ProfileHeader_t;
 
 typedef struct {
-	uint8_t  itemsCount;			// Number of profiles stored
+	uint16_t itemsCount;			// Number of profiles stored
 	uint16_t itemLength;			// Length of each profile item
 	bool     muteSound;				// Mute sound (default: false)
+	uint16_t orderLength;			// Entries reserved for the order array
+	uint16_t slotsCount;			// Number of record slots in file (used or free)
 } ProfileHeaderData_t;
 
+typedef struct {
+	uint8_t  revision;				// PROF_BENCH_REV (0: no results stored)
+	uint16_t year;					// Measurement date: Year
+	uint8_t  month;					// Measurement date: Month
+	uint8_t  day;					// Measurement date: Day
+	uint16_t cpuMhz100;				// Effective CPU speed (1/100 MHz)
+	uint16_t diskKBs;				// Disk sequential read (KB/s, 0: error)
+	uint16_t vramKBs;				// VRAM write (KB/s)
+} ProfileBench_t;
+
 typedef struct {
 	char     description[60];		// AsciiZ
 	uint16_t modifYear;				// Modification date: Year
 	uint8_t  modifMonth;			// Modification date: Month
 	uint8_t  modifDay;				// Modification date: Day
 	uint8_t  cmd[PROF_CMDSIZE];		// SetSmart commands
-	uint8_t  reserved[24];			// Reserved
+	ProfileBench_t bench;			// Latest quick benchmark results (in the former reserved bytes)
+	uint8_t  reserved[PROF_RESERVED - sizeof(ProfileBench_t)];	// Reserved
 } ProfileItem_t;
 
+typedef enum {
+	PROF_SORT_NAME,					// By description (A-Z)
+	PROF_SORT_DATE,					// By modification date (newest first)
+} ProfileSort_t;
+
 
 // ========================================================
 // Functions
 
-void profile_init();
+// Returned ProfileItem_t pointers are only valid until the next profile_* call.
+bool profile_init();
 void profile_release();
 bool profile_loadFile();
 bool profile_saveFile();
+bool profile_needsSave();
 ProfileHeader_t* profile_getHeader();
 ProfileHeaderData_t* profile_getHeaderData();
-uint8_t profile_newItem();
-ProfileItem_t* profile_getItem(uint8_t idx);
-bool profile_updateItem(uint8_t idx);
-bool profile_deleteItem(uint8_t idx);
+uint16_t profile_newItem();
+ProfileItem_t* profile_getItem(uint16_t idx);
+ProfileItem_t* profile_editItem(uint16_t idx);
+bool profile_updateItem(uint16_t idx);
+bool profile_deleteItem(uint16_t idx);
+bool profile_moveItem(uint16_t idx, int8_t moveTo);
+bool profile_sortItems(ProfileSort_t sortBy);
+bool profile_indexItem(uint16_t idx);
+uint16_t profile_setFilter(char *prefix);
+uint16_t profile_getFilteredItem(uint16_t pos);
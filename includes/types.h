@@ -53,6 +53,7 @@ typedef enum {
 	// Custom widgets
 	CUSTOM_CPUCLOCK_VALUE,
 	CUSTOM_VOLUME_SLIDER,
+	CUSTOM_DIAG_VALUE,
 } Widget_t;
 
 typedef enum {
@@ -60,6 +61,11 @@ typedef enum {
 	CMDTYPE_STANDARD,
 	CMDTYPE_CUSTOM_CPUMODE,
 	CMDTYPE_CUSTOM_SLOTS12,
+	CMDTYPE_CUSTOM_BENCHCPU,
+	CMDTYPE_CUSTOM_BENCHDISK,
+	CMDTYPE_CUSTOM_BENCHVDP,
+	CMDTYPE_CUSTOM_BENCHMAPPER,
+	CMDTYPE_CUSTOM_BENCHTUNE,
 } CmdType_t;
 
 enum										// Masks for Element_t.attribs.raw
@@ -74,19 +80,21 @@ enum										// Masks for Element_t.attribs.raw
 	ATR_UNUSED1          = 128,
 };
 
+// Element hot fields: the ones used to draw, navigate and change the values.
+// Kept at 16 bytes so the index of an element is its array offset >> 4,
+// and the same index gets its ElementInfo_t.
+// The tables are generated from res/panels.ini by bin/parse_panels.js.
 typedef struct {
-	Widget_t type;							// Widget type
+	uint8_t type;							// Widget type (Widget_t)
 	uint8_t posX, posY;						// Element position
-	uint16_t label;							// Element text label
 	int8_t goUp, goDown, goLeft, goRight;	// Navigation to indexes (relative offset)
 	uint8_t *value;							// Cached full byte for value
 	uint8_t valueMask;						// Mask for value
+	uint8_t valueShift;						// Bits to shift the masked value
 	uint8_t minValue;						// Min value
 	uint8_t maxValue;						// Max value
-	uint16_t *valueStr;						// Array with labels for each value
-	uint8_t valueOffsetX;					// Offset X for value widget
-	CmdType_t cmdType;						// OCM Smart Cmd type mode
-	uint8_t cmd[9];							// OCM Smart Cmd to set each value
+	uint8_t valueX;							// Position X for value widget
+	uint8_t cmdType;						// OCM Smart Cmd type mode (CmdType_t)
 	union {
 		uint8_t attribs_raw;
 		struct {
@@ -99,13 +107,30 @@ typedef struct {
 			unsigned reserved: 2;			// Not used flags [reserved]
 		};
 	};
+} Element_t;
+
+// Element cold fields: texts, commands and support info (same index as Element_t)
+typedef struct {
+	uint8_t labelLen;						// Element text label length
+	uint16_t *valueStr;						// Array with labels for each value
+	uint8_t *cmd;							// OCM Smart Cmd to set each value (NULL: none)
 	uint16_t description[ELEMENT_MAX_DESC];	// Description lines
 	IOrev_t ioRevNeeded;					// I/O Revision needed [0x00:all 0xff:n/a]
 	MachineMask_t supportedBy;				// Supported machines
-} Element_t;
+} ElementInfo_t;
+
+// Static label layer item: labels drawn straight to VRAM with each panel redraw
+typedef struct {
+	uint16_t vram;							// Name table address of the label
+	uint16_t label;							// Element text label
+	uint8_t len;							// Label length [0: end of layer]
+} PanelLabel_t;
 
 typedef struct {
 	uint16_t title;							// Panel name at top header
 	uint8_t titlex, titley, titlelen;		// Position & llength at top header
 	Element_t *elements;					// Array of elements
+	ElementInfo_t *infos;					// Array of elements cold fields
+	PanelLabel_t *labels;					// Static label layer
+	uint8_t *avail;							// Elements availability bitmap (bit N: element N)
 } Panel_t;
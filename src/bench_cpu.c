@@ -0,0 +1,132 @@
+/*
+	Copyright (c) 2024 Natalia Pujol Cremades
+	info@abitwitches.com
+
+	See LICENSE file.
+*/
+#pragma opt_code_size
+#include <stdint.h>
+#include "msx_const.h"
+#include "conio.h"
+#include "utils.h"
+#include "ocm_ioports.h"
+#include "bench.h"
+#include "bench_cpu.h"
+#include "strings_index.h"
+
+
+// ========================================================
+static const uint8_t speedCmds[BENCHCPU_SPEEDS] = {
+	OCM_SMART_CPU358MHz, OCM_SMART_CPU410MHz, OCM_SMART_CPU448MHz, OCM_SMART_CPU490MHz,
+	OCM_SMART_CPU539MHz, OCM_SMART_CPU610MHz, OCM_SMART_CPU696MHz, OCM_SMART_CPU806MHz
+};
+static const uint16_t speedStr[BENCHCPU_SPEEDS] = {
+	VALUE_CPUCLK_7, VALUE_CPUCLK_0, VALUE_CPUCLK_1, VALUE_CPUCLK_2,
+	VALUE_CPUCLK_3, VALUE_CPUCLK_4, VALUE_CPUCLK_5, VALUE_CPUCLK_6
+};
+
+
+// ========================================================
+/**
+ * @brief Counts the calibrated loop iterations done in a number of frames.
+ * Starts at a JIFFY change, so the whole frames are measured.
+ * @param frames Frames to measure (the counter overflows beyond ~15 MHz at 8 frames)
+ * @return Loop iterations
+ */
+static uint16_t countLoops(uint8_t frames) __naked __z88dk_fastcall
+{
+	frames;								// L = Param frames
+	__asm
+		ld   c, l						; C = Param frames
+		ld   hl, #JIFFY
+		ld   a, (hl)
+	.bcpu_sync:							; wait for the next interrupt
+		cp   (hl)
+		jr   z, .bcpu_sync
+		ld   a, (hl)
+		add  a, c
+		ld   e, a						; E = JIFFY low byte to stop at
+		ld   bc, #0
+	.bcpu_loop:							; BENCHCPU_LOOP_TSTATES (31)
+		inc  bc							; 7
+		ld   a, (hl)					; 8
+		cp   e							; 5
+		jp   nz, .bcpu_loop				; 11
+		ld   h, b						; Returns HL = iterations
+		ld   l, c
+		ret
+	__endasm;
+}
+
+/**
+ * @brief Returns the smart command that sets the current CPU speed setting,
+ * used to restore it after a sweep.
+ */
+uint8_t bench_cpuCurrentCmd()
+{
+	OCM_P42_VirtualDIP_t dips;
+	OCM_P47_SysInfo0_t info0;
+	OCM_P48_SysInfo1_t info1;
+
+	dips.raw = ocm_getPortValue(OCM_VIRTDIPS_PORT);
+	if (dips.cpuClock) {
+		info0.raw = ocm_getPortValue(OCM_SYSINFO0_PORT);
+		return OCM_SMART_CPU358MHz + info0.cpuCustomSpeed;
+	}
+	info1.raw = ocm_getPortValue(OCM_SYSINFO1_PORT);
+	return info1.turboPana ? OCM_SMART_TurboPana : OCM_SMART_CPU358MHz;
+}
+
+/**
+ * @brief Measures the effective speed of the current CPU setting.
+ * Interrupt handling time is included, as in any running program.
+ */
+void bench_cpuMeasure(BenchCpu_t *result)
+{
+	uint32_t hz = (uint32_t)countLoops(BENCHCPU_FRAMES) * BENCHCPU_LOOP_TSTATES *
+		BENCH_FRAMERATE() / BENCHCPU_FRAMES;
+
+	result->cmd = bench_cpuCurrentCmd();
+	result->mhz100 = hz / 10000;
+	result->ratio100 = hz / 35795;		// 3.579545 MHz / 100
+}
+
+/**
+ * @brief Measures the 3.58 MHz speed and the 7 custom ones, restoring the
+ * original setting at the end.
+ * @param results Array of BENCHCPU_SPEEDS results
+ */
+void bench_cpuSweep(BenchCpu_t *results)
+{
+	uint8_t original = bench_cpuCurrentCmd();
+
+	for (uint8_t i = 0; i < BENCHCPU_SPEEDS; i++, results++) {
+		ocm_sendSmartCmd(speedCmds[i]);
+		waitVBLANK();					// Let the new clock settle
+		bench_cpuMeasure(results);
+		results->cmd = speedCmds[i];
+	}
+	ocm_sendSmartCmd(original);
+}
+
+/**
+ * @brief Returns the name of a speed setting (i.e. "4.10MHz").
+ * @param cmd Smart command of the speed setting
+ */
+char *bench_cpuSpeedName(uint8_t cmd)
+{
+	if (cmd == OCM_SMART_TurboPana) {
+		return getString(VALUE_CPUCLK_8);
+	}
+	return getString(speedStr[cmd - OCM_SMART_CPU358MHz]);
+}
+
+/**
+ * @brief Formats a result as "<setting>: <effective>MHz (x<ratio>)".
+ */
+void bench_cpuFormat(char *str, BenchCpu_t *result)
+{
+	csprintf(str, getString(INFO_BENCHCPU_RESULT), bench_cpuSpeedName(result->cmd),
+		result->mhz100 / 100, result->mhz100 / 10 % 10, result->mhz100 % 10,
+		result->ratio100 / 100, result->ratio100 / 10 % 10, result->ratio100 % 10);
+}
@@ -0,0 +1,164 @@
+/*
+	Copyright (c) 2024 Natalia Pujol Cremades
+	info@abitwitches.com
+
+	See LICENSE file.
+*/
+#pragma opt_code_size
+#include <stdint.h>
+#include <string.h>
+#include "msx_const.h"
+#include "conio.h"
+#include "dos.h"
+#include "heap.h"
+#include "utils.h"
+#include "ocm_ioports.h"
+#include "bench.h"
+#include "bench_disk.h"
+#include "strings_index.h"
+
+
+// ========================================================
+#define ENV_BENCH			"OCMINFO_BENCH"		// Temporary file path
+#define BENCHDISK_FILE		"OCMBENCH.TMP"
+#define BENCHDISK_PATHLEN	64
+
+// Table columns
+#define COL_WRITE			16
+#define COL_READ			30
+#define COL_RANDOM			44
+
+
+// ========================================================
+static uint16_t perSecond(uint16_t amount, uint16_t start)
+{
+	uint16_t ticks = varJIFFY - start;
+	if (!ticks) ticks = 1;
+	return (uint32_t)amount * BENCH_FRAMERATE() / ticks;
+}
+
+static char *padTo(char *ptr, char *str, uint8_t column)
+{
+	while (ptr - str < column) *ptr++ = ' ';
+	return ptr;
+}
+
+/**
+ * @brief Measures the disk throughput with the current Turbo MegaSD setting.
+ * The temporary file is removed at the end.
+ * @param sizeKB Temporary file size (multiple of 4KB)
+ */
+void bench_diskRun(BenchDisk_t *result, uint16_t sizeKB)
+{
+	char *path, *buffer;
+	uint16_t chunks = sizeKB / (BENCHDISK_CHUNK / 1024);
+	uint16_t start, i, seed = 1;
+	OCM_P47_SysInfo0_t info0;
+	FILEH fh;
+
+	memset(result, 0, sizeof(BenchDisk_t));
+	info0.raw = ocm_getPortValue(OCM_SYSINFO0_PORT);
+	result->turboMegaSD = info0.turboMegaSD;
+
+	// Not enough memory: reported as the DOS2 error
+	if (!(path = malloc(BENCHDISK_PATHLEN))) {
+		result->error = ERR_NORAM;
+		return;
+	}
+	if (!(buffer = malloc(BENCHDISK_CHUNK))) {
+		result->error = ERR_NORAM;
+		free(BENCHDISK_PATHLEN);
+		return;
+	}
+	if (dos2_getEnv(ENV_BENCH, path, BENCHDISK_PATHLEN) || !*path) {
+		strcpy(path, BENCHDISK_FILE);
+	}
+
+	// Sequential write, closing the file to flush the DOS buffers
+	start = varJIFFY;
+	fh = dos2_fcreate(path, O_RDWR, ATTR_NONE);
+	if (fh >= ERR_FIRST) {
+		result->error = fh;
+		goto bench_end;
+	}
+	for (i = 0; i < chunks; i++) {
+		if (dos2_fwrite(buffer, BENCHDISK_CHUNK, fh) != BENCHDISK_CHUNK) {
+			result->error = ERR_DKFUL;
+			break;
+		}
+	}
+	dos2_fclose(fh);
+	if (result->error) goto bench_remove;
+	result->writeKBs = perSecond(sizeKB, start);
+
+	// Sequential read
+	start = varJIFFY;
+	fh = dos2_fopen(path, O_RDONLY);
+	if (fh >= ERR_FIRST) {
+		result->error = fh;
+		goto bench_remove;
+	}
+	for (i = 0; i < chunks; i++) {
+		if (dos2_fread(buffer, BENCHDISK_CHUNK, fh) != BENCHDISK_CHUNK) {
+			result->error = ERR_EOF;
+			goto bench_close;
+		}
+	}
+	result->readKBs = perSecond(sizeKB, start);
+
+	// Random reads, the same sequence of sectors on each run
+	start = varJIFFY;
+	for (i = 0; i < BENCHDISK_RANDOM; i++) {
+		seed = seed * 25173 + 13849;
+		dos2_fseek(fh, (uint32_t)(seed % (chunks * (BENCHDISK_CHUNK / BENCHDISK_RANDOMSIZE))) * BENCHDISK_RANDOMSIZE, SEEK_SET);
+		if (dos2_fread(buffer, BENCHDISK_RANDOMSIZE, fh) != BENCHDISK_RANDOMSIZE) {
+			result->error = ERR_EOF;
+			goto bench_close;
+		}
+	}
+	result->randomRps = perSecond(BENCHDISK_RANDOM, start);
+
+bench_close:
+	dos2_fclose(fh);
+bench_remove:
+	dos2_remove(path);
+bench_end:
+	free(BENCHDISK_CHUNK + BENCHDISK_PATHLEN);
+}
+
+/**
+ * @brief Measures the disk throughput with Turbo MegaSD OFF and ON,
+ * restoring the original setting at the end.
+ * @param results Array of 2 results
+ */
+void bench_diskSweep(BenchDisk_t *results, uint16_t sizeKB)
+{
+	OCM_P47_SysInfo0_t info0;
+
+	info0.raw = ocm_getPortValue(OCM_SYSINFO0_PORT);
+	ocm_sendSmartCmd(OCM_SMART_TMegaSDOFF);
+	bench_diskRun(&results[0], sizeKB);
+	ocm_sendSmartCmd(OCM_SMART_TMegaSDON);
+	bench_diskRun(&results[1], sizeKB);
+	ocm_sendSmartCmd(info0.turboMegaSD ? OCM_SMART_TMegaSDON : OCM_SMART_TMegaSDOFF);
+}
+
+/**
+ * @brief Formats a result as a row of the INFO_BENCHDISK_HEADER table.
+ */
+void bench_diskFormat(char *str, BenchDisk_t *result)
+{
+	char *ptr = str;
+
+	csprintf(ptr, " %s", getString(result->turboMegaSD ? VALUE_ONOFF_1 : VALUE_ONOFF_0));
+	ptr = padTo(ptr + strlen(ptr), str, COL_WRITE);
+	if (result->error) {
+		csprintf(ptr, getString(INFO_BENCHDISK_ERROR), result->error);
+		return;
+	}
+	csprintf(ptr, getString(INFO_BENCHDISK_KBS), result->writeKBs);
+	ptr = padTo(ptr + strlen(ptr), str, COL_READ);
+	csprintf(ptr, getString(INFO_BENCHDISK_KBS), result->readKBs);
+	ptr = padTo(ptr + strlen(ptr), str, COL_RANDOM);
+	csprintf(ptr, getString(INFO_BENCHDISK_RPS), result->randomRps);
+}
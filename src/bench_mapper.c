@@ -0,0 +1,421 @@
+/*
+	Copyright (c) 2024 Natalia Pujol Cremades
+	info@abitwitches.com
+
+	See LICENSE file.
+*/
+#pragma opt_code_size
+#include <stdint.h>
+#include <string.h>
+#include "msx_const.h"
+#include "conio.h"
+#include "heap.h"
+#include "utils.h"
+#include "bench.h"
+#include "bench_mapper.h"
+#include "strings_index.h"
+
+
+// ========================================================
+// DOS2 mapper support routines (offsets in the jump table)
+#define MAPPER_ALL_SEG		0x00
+#define MAPPER_FRE_SEG		0x03
+#define MAPPER_GET_P2		0x27
+
+#define PAGE2_START			0x8000
+#define PAGE3_START			0xC000
+#define SEGMENT_KB			16
+
+// Table columns
+#define COL_WIDTH			12
+
+typedef struct {
+	uint8_t segment;					// Segment to test
+	uint8_t original;					// Segment to restore in page 2
+	uint8_t pattern[BENCHMAP_PATTERN];
+} MapperJob_t;
+
+static const uint16_t errorStr[] = {
+	0, INFO_BENCHMAP_NOSUPPORT, INFO_BENCHMAP_PAGE2, INFO_BENCHMAP_NOFREE, INFO_BENCH_NOMEMORY
+};
+
+static uint16_t mapperTable;			// DOS2 mapper routines jump table
+
+
+// ========================================================
+// Mapper support routines
+
+/**
+ * @brief Gets the DOS2 mapper support routines with EXTBIO.
+ * @param totalSegs Returns the total segments of the primary mapper
+ * @return Jump table address, or 0 if there is no mapper support
+ */
+static uint16_t getMapperTable(uint8_t *totalSegs) __naked __z88dk_fastcall
+{
+	totalSegs;							// HL = Param totalSegs
+	__asm
+		push ix
+		push iy
+		push hl
+		ld   hl, #0
+		ld   a, (#HOKVLD)
+		rrca
+		jr   nc, .bmap_nosupport
+		xor  a
+		ld   de, #0x0402				; Get mapper support routine address
+		call #EXTBIO					; A = total segments, HL = jump table
+	.bmap_nosupport:
+		pop  de
+		ld   (de), a
+		pop  iy
+		pop  ix
+		ret
+	__endasm;
+}
+
+/**
+ * @brief Allocates a user segment of the primary mapper (ALL_SEG).
+ * @return Segment number, or 0x100+ if there are no free segments
+ */
+static uint16_t allocSegment() __naked __sdcccall(1)
+{
+	__asm
+		push ix
+		ld   hl, (_mapperTable)			; ALL_SEG
+		xor  a							; A = 0: user segment
+		ld   b, a						; B = 0: primary mapper only
+		call .bmap_callhl
+		ld   e, a
+		ld   d, #0
+		jr   nc, .bmap_allocated
+		inc  d							; No free segments
+	.bmap_allocated:
+		pop  ix
+		ret								; Returns DE = segment
+	.bmap_callhl:
+		jp   (hl)
+	__endasm;
+}
+
+/**
+ * @brief Frees a segment of the primary mapper (FRE_SEG).
+ */
+static void freeSegment(uint8_t segment) __naked __z88dk_fastcall
+{
+	segment;							// L = Param segment
+	__asm
+		push ix
+		ld   a, l
+		ld   b, #0						; B = 0: primary mapper
+		ld   hl, (_mapperTable)
+		ld   de, #MAPPER_FRE_SEG
+		add  hl, de
+		call .bmap_callhl
+		pop  ix
+		ret
+	__endasm;
+}
+
+/**
+ * @brief Returns the segment currently mapped in page 2 (GET_P2).
+ */
+static uint8_t getPage2Segment() __naked __sdcccall(1)
+{
+	__asm
+		push ix
+		ld   hl, (_mapperTable)
+		ld   de, #MAPPER_GET_P2
+		add  hl, de
+		call .bmap_callhl
+		pop  ix
+		ret								; Returns A = segment
+	__endasm;
+}
+
+
+// ========================================================
+// Page 2 tests: these routines map the tested segment in page 2 and restore
+// the original one before returning, so only code, the job and the stack
+// (pages 0, 1 and 3) can be used meanwhile.
+
+/**
+ * @brief Writes the pattern in the whole segment: the block N (256 bytes)
+ * gets the pattern from the offset N, so the address lines A0-A13 and the
+ * segment number take part in each byte.
+ */
+static void fillSegment(MapperJob_t *job) __naked __z88dk_fastcall
+{
+	job;								// HL = Param job
+	__asm
+		ld   a, (hl)					; A = segment
+		inc  hl
+		ld   c, (hl)					; C = original segment
+		inc  hl							; HL = pattern
+		push bc
+		out  (#0xfe), a
+		ld   de, #PAGE2_START
+	.bmap_fill:
+		push hl
+		ld   bc, #256
+		ldir
+		pop  hl
+		inc  hl
+		bit  6, d						; Until 0xC000
+		jr   z, .bmap_fill
+		pop  bc
+		ld   a, c
+		out  (#0xfe), a
+		ret
+	__endasm;
+}
+
+/**
+ * @brief Verifies the pattern written by fillSegment.
+ * @return true if the whole segment is right
+ */
+static bool verifySegment(MapperJob_t *job) __naked __z88dk_fastcall
+{
+	job;								// HL = Param job
+	__asm
+		ld   a, (hl)					; A = segment
+		inc  hl
+		ld   c, (hl)					; C = original segment
+		inc  hl							; HL = pattern
+		push bc
+		out  (#0xfe), a
+		ld   de, #PAGE2_START
+	.bmap_verifyblock:
+		push hl
+		ld   b, #0						; 256 bytes
+	.bmap_verify:
+		ld   a, (de)
+		cp   (hl)
+		jr   nz, .bmap_verifyfail
+		inc  hl
+		inc  e
+		djnz .bmap_verify
+		pop  hl
+		inc  hl
+		inc  d
+		bit  6, d						; Until 0xC000
+		jr   z, .bmap_verifyblock
+		ld   l, #1
+		jr   .bmap_verifyend
+	.bmap_verifyfail:
+		pop  hl
+		ld   l, #0
+	.bmap_verifyend:
+		pop  bc
+		ld   a, c
+		out  (#0xfe), a
+		ret								; Returns L = result
+	__endasm;
+}
+
+/**
+ * @brief Counts the BENCHMAP_LDIRSIZE bytes LDIRs done inside the segment
+ * in BENCHMAP_FRAMES frames, starting at a JIFFY change.
+ * @return LDIRs done
+ */
+static uint16_t countLdir(MapperJob_t *job) __naked __z88dk_fastcall
+{
+	job;								// HL = Param job
+	__asm
+		push ix
+		ld   a, (hl)					; A = segment
+		inc  hl
+		ld   c, (hl)					; C = original segment
+		push bc
+		out  (#0xfe), a
+		ld   hl, #JIFFY
+		ld   a, (hl)
+	.bmap_ldirsync:						; wait for the next interrupt
+		cp   (hl)
+		jr   z, .bmap_ldirsync
+		ld   a, (hl)
+		add  a, #BENCHMAP_FRAMES
+		exx
+		ld   e, a						; E' = JIFFY low byte to stop at
+		exx
+		ld   ix, #0
+	.bmap_ldir:
+		ld   hl, #PAGE2_START
+		ld   de, #PAGE2_START + 0x2000
+		ld   bc, #BENCHMAP_LDIRSIZE
+		ldir
+		inc  ix
+		ld   a, (#JIFFY)
+		exx
+		cp   e
+		exx
+		jr   nz, .bmap_ldir
+		pop  bc
+		ld   a, c
+		out  (#0xfe), a
+		push ix							; Returns HL = LDIRs
+		pop  hl
+		pop  ix
+		ret
+	__endasm;
+}
+
+/**
+ * @brief Counts the loop iterations done in BENCHMAP_FRAMES frames, each one
+ * switching page 2 to the tested segment and back to the original one.
+ * @return Iterations (2 switches each)
+ */
+static uint16_t countSwitches(MapperJob_t *job) __naked __z88dk_fastcall
+{
+	job;								// HL = Param job
+	__asm
+		push ix
+		ld   d, (hl)					; D = segment
+		inc  hl
+		ld   e, (hl)					; E = original segment
+		ld   c, #0xfe
+		ld   hl, #JIFFY
+		ld   a, (hl)
+	.bmap_switchsync:					; wait for the next interrupt
+		cp   (hl)
+		jr   z, .bmap_switchsync
+		ld   a, (hl)
+		add  a, #BENCHMAP_FRAMES
+		ld   b, a						; B = JIFFY low byte to stop at
+		ld   ix, #0
+	.bmap_switch:
+		out  (c), d
+		out  (c), e
+		inc  ix
+		ld   a, (hl)
+		cp   b
+		jp   nz, .bmap_switch
+		push ix							; Returns HL = iterations
+		pop  hl
+		pop  ix
+		ret
+	__endasm;
+}
+
+/**
+ * @brief End mark of the page 2 tests code, which must be below page 2.
+ */
+static void page2TestsEnd() __naked
+{
+	__asm
+		ret
+	__endasm;
+}
+
+
+// ========================================================
+static uint16_t perSecond(uint32_t amount, uint16_t start)
+{
+	uint16_t ticks = varJIFFY - start;
+	if (!ticks) ticks = 1;
+	return amount * BENCH_FRAMERATE() / ticks;
+}
+
+/**
+ * @brief Runs the RAM check over all the free segments and the speed tests.
+ * All the segments allocated are freed at the end.
+ * @return false if there was an error or a segment failed the check
+ */
+bool bench_mapperRun(BenchMapper_t *result)
+{
+	MapperJob_t job;					// In the stack (page 3)
+	uint8_t *segments = malloc(256);
+	uint16_t count = 0, i, j, seg, start;
+	uint8_t totalSegs;
+
+	memset(result, 0, sizeof(BenchMapper_t));
+	if (!segments) {
+		result->error = BENCHMAP_ERR_NORAM;
+		return false;
+	}
+
+	mapperTable = getMapperTable(&totalSegs);
+	if (!mapperTable) {
+		result->error = BENCHMAP_ERR_NOSUPPORT;
+		goto bench_end;
+	}
+	result->totalKB = (totalSegs ? totalSegs : 256) * SEGMENT_KB;
+	if ((uint16_t)page2TestsEnd >= PAGE2_START || (uint16_t)&job < PAGE3_START) {
+		result->error = BENCHMAP_ERR_PAGE2;
+		goto bench_end;
+	}
+
+	// Allocate all the free segments
+	while (count < 256 && (seg = allocSegment()) < 0x100) {
+		segments[count++] = seg;
+	}
+	if (!count) {
+		result->error = BENCHMAP_ERR_NOFREE;
+		goto bench_end;
+	}
+	result->freeKB = count * SEGMENT_KB;
+	job.original = getPage2Segment();
+
+	// Pattern write of all the segments before verifying them, so the
+	// segments mirrored in the same memory are detected too
+	start = varJIFFY;
+	for (i = 0; i < count; i++) {
+		job.segment = segments[i];
+		for (j = 0; j < BENCHMAP_PATTERN; j++) {
+			job.pattern[j] = (uint8_t)j ^ job.segment;
+		}
+		fillSegment(&job);
+	}
+	for (i = 0; i < count; i++) {
+		job.segment = segments[i];
+		for (j = 0; j < BENCHMAP_PATTERN; j++) {
+			job.pattern[j] = (uint8_t)j ^ job.segment;
+		}
+		if (verifySegment(&job)) result->verifiedKB += SEGMENT_KB;
+	}
+	result->checkKBs = perSecond((uint32_t)result->freeKB * 2, start);
+
+	// Speed tests with the first segment
+	job.segment = segments[0];
+	result->ldirKBs = (uint32_t)countLdir(&job) * (BENCHMAP_LDIRSIZE / 1024) *
+		BENCH_FRAMERATE() / BENCHMAP_FRAMES;
+	result->switchK10 = (uint32_t)countSwitches(&job) * 2 *
+		BENCH_FRAMERATE() / BENCHMAP_FRAMES / 100;
+
+	while (count) {
+		freeSegment(segments[--count]);
+	}
+
+bench_end:
+	free(256);
+	return !result->error && result->verifiedKB == result->freeKB;
+}
+
+/**
+ * @brief Formats a result as a row of the INFO_BENCHMAP_HEADER table,
+ * or the error message.
+ */
+void bench_mapperFormat(char *str, BenchMapper_t *result)
+{
+	char *ptr = str;
+
+	if (result->error) {
+		strcpy(str, getString(errorStr[result->error]));
+		return;
+	}
+	csprintf(ptr, getString(INFO_BENCHMAP_KB), result->totalKB);
+	ptr += strlen(ptr);
+	while (ptr - str < COL_WIDTH) *ptr++ = ' ';
+	csprintf(ptr, getString(INFO_BENCHMAP_KB), result->freeKB);
+	ptr += strlen(ptr);
+	while (ptr - str < COL_WIDTH * 2) *ptr++ = ' ';
+	csprintf(ptr, getString(INFO_BENCHMAP_KB), result->verifiedKB);
+	ptr += strlen(ptr);
+	while (ptr - str < COL_WIDTH * 3) *ptr++ = ' ';
+	csprintf(ptr, getString(INFO_BENCHDISK_KBS), result->checkKBs);
+	ptr += strlen(ptr);
+	while (ptr - str < COL_WIDTH * 4) *ptr++ = ' ';
+	csprintf(ptr, getString(INFO_BENCHDISK_KBS), result->ldirKBs);
+	ptr += strlen(ptr);
+	while (ptr - str < COL_WIDTH * 5) *ptr++ = ' ';
+	csprintf(ptr, getString(INFO_BENCHMAP_SWITCHES), result->switchK10 / 10, result->switchK10 % 10);
+}
@@ -0,0 +1,59 @@
+/*
+	Copyright (c) 2024 Natalia Pujol Cremades
+	info@abitwitches.com
+
+	See LICENSE file.
+*/
+#pragma opt_code_size
+#include <stdint.h>
+#include <string.h>
+#include "msx_const.h"
+#include "conio.h"
+#include "dos.h"
+#include "utils.h"
+#include "bench_cpu.h"
+#include "bench_disk.h"
+#include "bench_vdp.h"
+#include "bench_quick.h"
+#include "strings_index.h"
+
+
+// ========================================================
+/**
+ * @brief Runs the quick benchmark with the current settings and dates it.
+ */
+void bench_quickRun(ProfileBench_t *bench)
+{
+	BenchCpu_t cpu;
+	BenchDisk_t disk;
+	SYSTEMDATE_t date;
+
+	memset(bench, 0, sizeof(ProfileBench_t));
+	bench_cpuMeasure(&cpu);
+	bench_diskRun(&disk, BENCHQUICK_DISKSIZE);
+	bench->cpuMhz100 = cpu.mhz100;
+	bench->diskKBs = disk.error ? 0 : disk.readKBs;
+	bench->vramKBs = bench_vdpVramWrite();
+
+	getSystemDate(&date);
+	bench->year = date.year;
+	bench->month = date.month;
+	bench->day = date.day;
+	bench->revision = PROF_BENCH_REV;
+}
+
+/**
+ * @brief Formats the results as "<cpu>MHz D:<disk> V:<vram>" (max BENCHQUICK_LEN chars),
+ * or an empty string if there are no results of the current revision.
+ */
+void bench_quickFormat(char *str, ProfileBench_t *bench)
+{
+	// Speeds over 99.99MHz can only come from a damaged record
+	uint16_t mhz100 = bench->cpuMhz100 > BENCHQUICK_MAXMHZ100 ? BENCHQUICK_MAXMHZ100 : bench->cpuMhz100;
+
+	*str = '\0';
+	if (bench->revision != PROF_BENCH_REV) return;
+	csprintf(str, getString(INFO_BENCHQUICK_ROW),
+		mhz100 / 100, mhz100 / 10 % 10, mhz100 % 10,
+		bench->diskKBs, bench->vramKBs);
+}
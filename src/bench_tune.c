@@ -0,0 +1,187 @@
+/*
+	Copyright (c) 2024 Natalia Pujol Cremades
+	info@abitwitches.com
+
+	See LICENSE file.
+*/
+#pragma opt_code_size
+#include <stdint.h>
+#include <string.h>
+#include "msx_const.h"
+#include "conio.h"
+#include "heap.h"
+#include "utils.h"
+#include "ocm_ioports.h"
+#include "profiles_api.h"
+#include "bench_cpu.h"
+#include "bench_tune.h"
+#include "strings_index.h"
+
+
+// ========================================================
+static const uint16_t statusStr[] = {
+	INFO_BENCHTUNE_SKIPPED, INFO_BENCHTUNE_PASS, INFO_BENCHTUNE_FAIL
+};
+
+static uint8_t romSlot;					// Slot read by readRomByte
+
+
+// ========================================================
+/**
+ * @brief Reads a byte of the romSlot slot with RDSLT.
+ */
+static uint8_t readRomByte(uint16_t address) __naked __sdcccall(1)
+{
+	address;							// HL = Param address
+	__asm
+		push ix
+		ld   a, (_romSlot)
+		call RDSLT
+		ei
+		pop  ix
+		ret								; Returns A = byte content
+	__endasm;
+}
+
+// Fletcher style checksum
+static uint16_t checksum(uint16_t sum, uint8_t value)
+{
+	uint8_t sum1 = (sum & 0xff) + value;
+	return ((sum + ((uint16_t)sum1 << 8)) & 0xff00) | sum1;
+}
+
+/**
+ * @brief Runs the checksum workload once.
+ * @param buffer BENCHTUNE_RAMSIZE bytes buffer
+ */
+static void runWorkload(BenchTuneSum_t *sum, uint8_t *buffer, uint8_t slotMask)
+{
+	uint16_t seed = 0x1234, value, i;
+	uint8_t slot;
+
+	memset(sum, 0, sizeof(BenchTuneSum_t));
+
+	// CPU: 16 bits multiplication, division and modulo
+	for (i = 0; i < BENCHTUNE_CPULOOPS; i++) {
+		seed = seed * 25173 + 13849;
+		value = seed / 7 + seed % 251;
+		sum->cpu = checksum(sum->cpu, value >> 8);
+		sum->cpu = checksum(sum->cpu, value);
+	}
+
+	// RAM: fill half the buffer, copy it to the other half and read all
+	for (i = 0; i < BENCHTUNE_RAMSIZE / 2; i++) {
+		seed = seed * 25173 + 13849;
+		buffer[i] = seed >> 8;
+	}
+	memcpy(buffer + BENCHTUNE_RAMSIZE / 2, buffer, BENCHTUNE_RAMSIZE / 2);
+	for (i = 0; i < BENCHTUNE_RAMSIZE; i++) {
+		sum->ram = checksum(sum->ram, buffer[i]);
+	}
+
+	// ROM: page 1 of the selected primary slots (sub-slot 0 if expanded)
+	for (slot = 0; slot < 4; slot++) {
+		if (!(slotMask & (1 << slot))) continue;
+		romSlot = slot | (varEXPTBL[slot] & 0x80);
+		for (i = 0; i < BENCHTUNE_ROMSIZE; i++) {
+			sum->rom = checksum(sum->rom, readRomByte(BENCHTUNE_ROMSTART + i));
+		}
+	}
+}
+
+/**
+ * @brief Runs the workload BENCHTUNE_RUNS times and compares the checksums.
+ * @return true if all the runs match the reference
+ */
+static bool checkSpeed(BenchTune_t *result, uint8_t *buffer)
+{
+	BenchTuneSum_t sum;
+
+	for (uint8_t i = 0; i < BENCHTUNE_RUNS; i++) {
+		runWorkload(&sum, buffer, result->slotMask);
+		if (memcmp(&sum, &result->reference, sizeof(BenchTuneSum_t))) return false;
+	}
+	return true;
+}
+
+/**
+ * @brief Finds the fastest stable custom speed, restoring the original
+ * setting at the end.
+ * @param slotMask Primary slots whose page 1 is read too (bit N: slot N)
+ * @return false if there is not enough memory to run it
+ */
+bool bench_tuneRun(BenchTune_t *result, uint8_t slotMask)
+{
+	uint8_t *buffer = malloc(BENCHTUNE_RAMSIZE);
+	uint8_t original = bench_cpuCurrentCmd();
+	uint8_t i;
+
+	memset(result, 0, sizeof(BenchTune_t));
+	result->slotMask = slotMask;
+	if (!buffer) return false;
+
+	// Reference checksums at 3.58MHz
+	ocm_sendSmartCmd(OCM_SMART_CPU358MHz);
+	waitVBLANK();
+	runWorkload(&result->reference, buffer, slotMask);
+
+	if (checkSpeed(result, buffer)) {
+		for (i = 0; i < BENCHTUNE_SPEEDS; i++) {
+			ocm_sendSmartCmd(OCM_SMART_CPU410MHz + i);
+			waitVBLANK();				// Let the new clock settle
+			if (!checkSpeed(result, buffer)) {
+				result->status[i] = TUNE_FAIL;
+				break;
+			}
+			result->status[i] = TUNE_PASS;
+			result->bestCmd = OCM_SMART_CPU410MHz + i;
+		}
+	}
+	ocm_sendSmartCmd(original);
+	free(BENCHTUNE_RAMSIZE);
+	return true;
+}
+
+/**
+ * @brief Adds a profile that only sets the fastest stable speed, and saves
+ * the profiles file.
+ * @return Profile number, or 0 if the profiles file can't be read or saved
+ */
+uint16_t bench_tuneSaveProfile(BenchTune_t *result)
+{
+	ProfileItem_t *profile;
+	uint16_t idx;
+
+	if (!result->bestCmd || !profile_loadFile()) return 0;
+	idx = profile_newItem();
+	if (idx == PROF_NOITEM || !(profile = profile_editItem(idx))) return 0;
+
+	csprintf(profile->description, getString(INFO_BENCHTUNE_PROFILE), bench_cpuSpeedName(result->bestCmd));
+	profile->cmd[0] = result->bestCmd;
+	profile->cmd[1] = 0x00;
+	profile_indexItem(idx);
+	if (!profile_saveFile()) return 0;
+	return idx + 1;
+}
+
+/**
+ * @brief Formats the result of a custom speed as "<speed>: <status>".
+ * @param index Custom speed index (0: 4.10MHz)
+ */
+void bench_tuneFormat(char *str, BenchTune_t *result, uint8_t index)
+{
+	csprintf(str, getString(INFO_BENCHTUNE_RESULT), bench_cpuSpeedName(OCM_SMART_CPU410MHz + index),
+		getString(statusStr[result->status[index]]));
+}
+
+/**
+ * @brief Formats the fastest stable speed found.
+ */
+void bench_tuneFormatBest(char *str, BenchTune_t *result)
+{
+	if (!result->bestCmd) {
+		strcpy(str, getString(INFO_BENCHTUNE_NONE));
+		return;
+	}
+	csprintf(str, getString(INFO_BENCHTUNE_BEST), bench_cpuSpeedName(result->bestCmd));
+}
@@ -0,0 +1,276 @@
+/*
+	Copyright (c) 2024 Natalia Pujol Cremades
+	info@abitwitches.com
+
+	See LICENSE file.
+*/
+#pragma opt_code_size
+#include <stdint.h>
+#include <string.h>
+#include "msx_const.h"
+#include "conio.h"
+#include "heap.h"
+#include "utils.h"
+#include "ocm_ioports.h"
+#include "bench.h"
+#include "bench_vdp.h"
+#include "blit80.h"
+#include "strings_index.h"
+
+
+// ========================================================
+#define BENCH_SCREEN		8			// 256x212 with 1 byte per pixel
+#define BLOCK_SIZE			256			// Bytes moved by each OTIR/INIR
+#define TEXT_FREE_VRAM		0x2000		// 8KB not used by the text modes
+#define TEXT_FREE_BLOCKS	32
+
+// Table columns
+#define COL_WIDTH			12
+
+// V9938 command registers R#32 to R#46
+typedef struct {
+	uint16_t sx, sy;
+	uint16_t dx, dy;
+	uint16_t nx, ny;
+	uint8_t  clr, arg, cmd;
+} VdpCommand_t;
+
+#define CMD_HMMV			0xc0
+#define CMD_HMMM			0xd0
+#define CMD_LMMM			0x90		// Logical operation IMP
+
+// 256x64 pixels each: fill the top band, and copy it to the next one
+static const VdpCommand_t cmdHMMV = { 0,0,  0,0,  256,64, 0x55, 0, CMD_HMMV };
+static const VdpCommand_t cmdHMMM = { 0,0,  0,64, 256,64, 0,    0, CMD_HMMM };
+static const VdpCommand_t cmdLMMM = { 0,0,  0,64, 256,64, 0,    0, CMD_LMMM };
+#define CMD_PIXELS			(256*64)
+
+
+// ========================================================
+static void changeMode(uint8_t mode) __naked __z88dk_fastcall
+{
+	mode;								// L = Param mode
+	__asm
+		push ix							; IX is the caller frame pointer
+		ld   a, l
+		ld   ix, #CHGMOD
+		BIOSCALL
+		pop  ix
+		ret
+	__endasm;
+}
+
+static void vramWriteBlock() __naked
+{
+	__asm
+		ld   hl, #0x0100				; Any memory is good as source
+		ld   bc, #0x0098				; B = 256 bytes
+		otir
+		ret
+	__endasm;
+}
+
+static void vramReadBlock(uint8_t *buffer) __naked __z88dk_fastcall
+{
+	buffer;								// HL = Param buffer
+	__asm
+		ld   bc, #0x0098				; B = 256 bytes
+		inir
+		ret
+	__endasm;
+}
+
+// Waits for the end of the current VDP command (S#2 CE bit)
+static void waitCommand() __naked
+{
+	__asm
+	.bvdp_wait:
+		di
+		ld   a, #2						; R#15 = 2 (read S#2)
+		out  (0x99), a
+		ld   a, #0x80+15
+		out  (0x99), a
+		in   a, (0x99)
+		ld   e, a
+		xor  a							; R#15 = 0 (the BIOS interrupt reads S#0)
+		out  (0x99), a
+		ld   a, #0x80+15
+		out  (0x99), a
+		ei
+		rrc  e
+		jr   c, .bvdp_wait
+		ret
+	__endasm;
+}
+
+static void vdpCommand(VdpCommand_t *command) __naked __z88dk_fastcall
+{
+	command;							// HL = Param command
+	__asm
+		call _waitCommand
+		di
+		ld   a, #32						; R#17 = 32 (auto-increment from R#32)
+		out  (0x99), a
+		ld   a, #0x80+17
+		out  (0x99), a
+		ld   bc, #0x0f9b				; 15 registers to port 0x9b
+		otir
+		ei
+		ret
+	__endasm;
+}
+
+static uint8_t syncFrame()
+{
+	uint8_t jiffy = varJIFFY;
+	while ((uint8_t)varJIFFY == jiffy);
+	return varJIFFY;
+}
+
+static bool isRunning(uint8_t start)
+{
+	return (uint8_t)((uint8_t)varJIFFY - start) < BENCHVDP_FRAMES;
+}
+
+static uint16_t kpxPerSecond(uint16_t count, uint16_t pixels, uint8_t start)
+{
+	uint8_t frames = (uint8_t)varJIFFY - start;
+	return (uint32_t)count * pixels * BENCH_FRAMERATE() / frames / 1000;
+}
+
+static uint16_t kbPerSecond(uint16_t count, uint16_t bytes, uint8_t start)
+{
+	uint8_t frames = (uint8_t)varJIFFY - start;
+	return (uint32_t)count * bytes * BENCH_FRAMERATE() / frames / 1024;
+}
+
+static uint16_t measureCommand(VdpCommand_t *command)
+{
+	uint16_t count = 0;
+	uint8_t start = syncFrame();
+
+	do {
+		vdpCommand(command);
+		waitCommand();
+		count++;
+	} while (isRunning(start));
+	return kpxPerSecond(count, CMD_PIXELS, start);
+}
+
+static uint8_t isVdpFast()
+{
+	OCM_P47_SysInfo0_t info0;
+	info0.raw = ocm_getPortValue(OCM_SYSINFO0_PORT);
+	return info0.vdpSpeed;
+}
+
+static void runTests(BenchVdp_t *result, uint8_t *buffer)
+{
+	uint16_t count;
+	uint8_t start;
+
+	result->vdpFast = isVdpFast();
+
+	// VRAM write
+	blit80_setVramAddress(VRAM_WRITE | 0x0000);
+	count = 0;
+	start = syncFrame();
+	do {
+		vramWriteBlock();
+		count++;
+	} while (isRunning(start));
+	result->vramWrite = kpxPerSecond(count, BLOCK_SIZE, start);
+
+	// VRAM read
+	blit80_setVramAddress(0x0000);
+	count = 0;
+	start = syncFrame();
+	do {
+		vramReadBlock(buffer);
+		count++;
+	} while (isRunning(start));
+	result->vramRead = kpxPerSecond(count, BLOCK_SIZE, start);
+
+	// Command engine
+	result->hmmv = measureCommand(&cmdHMMV);
+	result->hmmm = measureCommand(&cmdHMMM);
+	result->lmmm = measureCommand(&cmdLMMM);
+}
+
+/**
+ * @brief Measures the VDP throughput with the current VDP speed setting.
+ * @return false if there is not enough memory to run it
+ */
+bool bench_vdpRun(BenchVdp_t *result)
+{
+	uint8_t mode = varSCRMOD;
+	uint8_t *buffer = malloc(BLOCK_SIZE);
+
+	memset(result, 0, sizeof(BenchVdp_t));
+	if (!buffer) return false;
+	changeMode(BENCH_SCREEN);
+	runTests(result, buffer);
+	changeMode(mode);
+	free(BLOCK_SIZE);
+	return true;
+}
+
+/**
+ * @brief Measures the VRAM write speed in the current text mode, without
+ * changing the screen: the writes go to VRAM not used by the text modes.
+ * @return VRAM write (KB/s)
+ */
+uint16_t bench_vdpVramWrite()
+{
+	uint16_t count = 0;
+	uint8_t start = syncFrame();
+
+	do {
+		blit80_setVramAddress(VRAM_WRITE | TEXT_FREE_VRAM | (count % TEXT_FREE_BLOCKS) * BLOCK_SIZE);
+		vramWriteBlock();
+		count++;
+	} while (isRunning(start));
+	return kbPerSecond(count, BLOCK_SIZE, start);
+}
+
+/**
+ * @brief Measures the VDP throughput in Normal and Fast modes, restoring
+ * the original setting at the end.
+ * @param results Array of 2 results
+ * @return false if there is not enough memory to run it
+ */
+bool bench_vdpSweep(BenchVdp_t *results)
+{
+	uint8_t mode = varSCRMOD;
+	uint8_t fast = isVdpFast();
+	uint8_t *buffer = malloc(BLOCK_SIZE);
+
+	memset(results, 0, sizeof(BenchVdp_t) * 2);
+	if (!buffer) return false;
+	changeMode(BENCH_SCREEN);
+	ocm_sendSmartCmd(OCM_SMART_VDPNormal);
+	runTests(&results[0], buffer);
+	ocm_sendSmartCmd(OCM_SMART_VDPFast);
+	runTests(&results[1], buffer);
+	ocm_sendSmartCmd(fast ? OCM_SMART_VDPFast : OCM_SMART_VDPNormal);
+	changeMode(mode);
+	free(BLOCK_SIZE);
+	return true;
+}
+
+/**
+ * @brief Formats a result as a row of the INFO_BENCHVDP_HEADER table.
+ */
+void bench_vdpFormat(char *str, BenchVdp_t *result)
+{
+	uint16_t *value = &result->vramWrite;
+	char *ptr = str;
+
+	strcpy(ptr, getString(result->vdpFast ? VALUE_VDPSPD_1 : VALUE_VDPSPD_0));
+	ptr += strlen(ptr);
+	for (uint8_t i = 1; i <= 5; i++, value++) {
+		while (ptr - str < i * COL_WIDTH) *ptr++ = ' ';
+		csprintf(ptr, "%u", *value);
+		ptr += strlen(ptr);
+	}
+}
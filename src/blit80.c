@@ -0,0 +1,258 @@
+/*
+	Copyright (c) 2024 Natalia Pujol Cremades
+	info@abitwitches.com
+
+	See LICENSE file.
+*/
+#pragma opt_code_size
+#include <stdint.h>
+#include <stdbool.h>
+#include "blit80.h"
+
+
+// ========================================================
+// Defines & tables
+
+#define NAME_ROW(y)			(BLIT80_NAMETABLE + (y) * BLIT80_WIDTH)
+#define BLINK_ROW(y)		(BLIT80_BLINKTABLE + (y) * (BLIT80_WIDTH / 8))
+
+static const uint16_t nameRows[BLIT80_ROWS] = {
+	NAME_ROW(0),  NAME_ROW(1),  NAME_ROW(2),  NAME_ROW(3),  NAME_ROW(4),  NAME_ROW(5),
+	NAME_ROW(6),  NAME_ROW(7),  NAME_ROW(8),  NAME_ROW(9),  NAME_ROW(10), NAME_ROW(11),
+	NAME_ROW(12), NAME_ROW(13), NAME_ROW(14), NAME_ROW(15), NAME_ROW(16), NAME_ROW(17),
+	NAME_ROW(18), NAME_ROW(19), NAME_ROW(20), NAME_ROW(21), NAME_ROW(22), NAME_ROW(23)
+};
+
+static const uint16_t blinkRows[BLIT80_ROWS] = {
+	BLINK_ROW(0),  BLINK_ROW(1),  BLINK_ROW(2),  BLINK_ROW(3),  BLINK_ROW(4),  BLINK_ROW(5),
+	BLINK_ROW(6),  BLINK_ROW(7),  BLINK_ROW(8),  BLINK_ROW(9),  BLINK_ROW(10), BLINK_ROW(11),
+	BLINK_ROW(12), BLINK_ROW(13), BLINK_ROW(14), BLINK_ROW(15), BLINK_ROW(16), BLINK_ROW(17),
+	BLINK_ROW(18), BLINK_ROW(19), BLINK_ROW(20), BLINK_ROW(21), BLINK_ROW(22), BLINK_ROW(23)
+};
+
+
+// ========================================================
+// VDP access
+
+/**
+ * @brief Sets the VRAM address (< 16KB) to read, or to write with VRAM_WRITE.
+ * Also used by the VDP benchmark.
+ */
+void blit80_setVramAddress(uint16_t address) __naked __z88dk_fastcall
+{
+	address;							// HL = Param address
+	__asm
+		di
+		xor  a							; R#14 = 0 (A16-A14)
+		out  (0x99), a
+		ld   a, #0x80+14
+		out  (0x99), a
+		ld   a, l
+		out  (0x99), a
+		ld   a, h
+		and  #0x7f
+		out  (0x99), a
+		ei
+		ret
+	__endasm;
+}
+
+/**
+ * @brief Writes up to 80 bytes to the VDP. The chain of OUTIs is entered
+ * at the last <length> of them, so no loop counter is needed.
+ */
+static void outiRun(uint8_t length, void *source) __naked __sdcccall(1)
+{
+	length;								// A = Param length
+	source;								// DE = Param source
+	__asm
+		ex   de, hl						; HL = source
+		ld   c, #0x98
+		add  a, a						; OUTI is 2 bytes long
+		ld   e, a
+		ld   d, #0
+		push hl
+		ld   hl, #.blit_outiEnd
+		or   a
+		sbc  hl, de						; HL = entry point
+		ex   (sp), hl					; HL = source, entry point at the stack
+		ret
+		.rept 80
+		outi
+		.endm
+	.blit_outiEnd:
+		ret
+	__endasm;
+}
+
+/**
+ * @brief Reads up to 80 bytes from the VDP with the same unrolled scheme
+ * as outiRun.
+ */
+static void iniRun(uint8_t length, void *target) __naked __sdcccall(1)
+{
+	length;								// A = Param length
+	target;								// DE = Param target
+	__asm
+		ex   de, hl						; HL = target
+		ld   c, #0x98
+		add  a, a						; INI is 2 bytes long
+		ld   e, a
+		ld   d, #0
+		push hl
+		ld   hl, #.blit_iniEnd
+		or   a
+		sbc  hl, de						; HL = entry point
+		ex   (sp), hl					; HL = target, entry point at the stack
+		ret
+		.rept 80
+		ini
+		.endm
+	.blit_iniEnd:
+		ret
+	__endasm;
+}
+
+// Writes <count> times the byte value (count > 0)
+static void fillRun(uint8_t count, uint8_t value) __naked __sdcccall(1)
+{
+	count;								// A = Param count
+	value;								// L = Param value
+	__asm
+		ld   b, a
+		ld   a, l
+	.blit_fill:
+		out  (0x98), a
+		djnz .blit_fill
+		ret
+	__endasm;
+}
+
+static uint8_t readByte() __naked __sdcccall(1)
+{
+	__asm
+		in   a, (0x98)
+		ret								; Returns A = byte read
+	__endasm;
+}
+
+static void writeByte(uint8_t value) __naked __sdcccall(1)
+{
+	value;								// A = Param value
+	__asm
+		out  (0x98), a
+		ret
+	__endasm;
+}
+
+// Changes the bits of a VRAM byte set in mask with the ones of value
+static void updateByte(uint16_t vram, uint8_t mask, uint8_t value)
+{
+	uint8_t current;
+
+	blit80_setVramAddress(vram);
+	current = readByte();
+	blit80_setVramAddress(VRAM_WRITE | vram);
+	writeByte((current & ~mask) | (value & mask));
+}
+
+
+// ========================================================
+/**
+ * @brief Writes a block of up to 80 bytes to a name table address.
+ */
+void blit80_putvram(uint16_t vram, uint8_t length, void *source)
+{
+	blit80_setVramAddress(VRAM_WRITE | vram);
+	outiRun(length, source);
+}
+
+/**
+ * @brief Writes a line of characters, like conio putlinexy.
+ */
+void blit80_putline(uint8_t x, uint8_t y, uint16_t length, void *source)
+{
+	blit80_setVramAddress(VRAM_WRITE | (nameRows[y - 1] + x - 1));
+	while (length > BLIT80_WIDTH) {
+		outiRun(BLIT80_WIDTH, source);
+		source = (uint8_t*)source + BLIT80_WIDTH;
+		length -= BLIT80_WIDTH;
+	}
+	outiRun(length, source);
+}
+
+/**
+ * @brief Writes a rectangle of characters, like conio puttext.
+ */
+void blit80_puttext(uint8_t left, uint8_t top, uint8_t right, uint8_t bottom, void *source)
+{
+	uint8_t width = right - left + 1;
+
+	if (width == BLIT80_WIDTH) {
+		blit80_setVramAddress(VRAM_WRITE | nameRows[top - 1]);
+	}
+	for (; top <= bottom; top++) {
+		if (width != BLIT80_WIDTH) {
+			blit80_setVramAddress(VRAM_WRITE | (nameRows[top - 1] + left - 1));
+		}
+		outiRun(width, source);
+		source = (uint8_t*)source + width;
+	}
+}
+
+/**
+ * @brief Reads a rectangle of characters, like conio gettext.
+ */
+void blit80_gettext(uint8_t left, uint8_t top, uint8_t right, uint8_t bottom, void *target)
+{
+	uint8_t width = right - left + 1;
+
+	if (width == BLIT80_WIDTH) {
+		blit80_setVramAddress(nameRows[top - 1]);
+	}
+	for (; top <= bottom; top++) {
+		if (width != BLIT80_WIDTH) {
+			blit80_setVramAddress(nameRows[top - 1] + left - 1);
+		}
+		iniRun(width, target);
+		target = (uint8_t*)target + width;
+	}
+}
+
+/**
+ * @brief Sets or clears the blink of a span of characters, like conio
+ * textblink. The whole bytes of the span are written directly.
+ */
+void blit80_blink(uint8_t x, uint8_t y, uint8_t length, bool enabled)
+{
+	uint16_t vram;
+	uint8_t bit, mask, value = enabled ? 0xff : 0x00;
+
+	if (!length) return;
+	x--;
+	vram = blinkRows[y - 1] + (x >> 3);
+	bit = x & 7;
+
+	// Partial first byte
+	if (bit) {
+		mask = 0xff >> bit;
+		if (length < 8 - bit) {
+			mask &= (uint8_t)~(0xff >> (bit + length));
+			length = 0;
+		} else {
+			length -= 8 - bit;
+		}
+		updateByte(vram++, mask, value);
+	}
+	// Whole bytes
+	if (length >= 8) {
+		blit80_setVramAddress(VRAM_WRITE | vram);
+		fillRun(length >> 3, value);
+		vram += length >> 3;
+		length &= 7;
+	}
+	// Partial last byte
+	if (length) {
+		updateByte(vram, (uint8_t)~(0xff >> length), value);
+	}
+}
@@ -10,10 +10,17 @@
 #include "msx_const.h"
 #include "dos.h"
 #include "conio.h"
+#include "heap.h"
 #include "utils.h"
 #include "globals.h"
 #include "ocm_ioports.h"
 #include "profiles_api.h"
+#include "bench_cpu.h"
+#include "bench_disk.h"
+#include "bench_vdp.h"
+#include "bench_mapper.h"
+#include "bench_tune.h"
+#include "bench_quick.h"
 #include "strings_index.h"
 
 
@@ -41,7 +48,7 @@ void printHelp()
 	cputs(
 		"https://github.com/nataliapc/msx_ocminfo\n"
 		"\n"
-		"Usage: OCMINFO [/n|/L] [/B] [/R] [/Q] [/?]\n"
+		"Usage: OCMINFO [/n|/L] [/B] [/R] [/T|/TS] [/D[S][k]] [/V|/VS] [/M] [/A[s]] [/Q] [/?]\n"
 		"\n"
 		"Use without parameters to open the interactive panels mode.\n"
 		"\n"
@@ -50,6 +57,16 @@ void printHelp()
 		"  /L    List the user profiles.\n"
 		"  /B    Print a .BTM file for the selected profile.\n"
 		"  /R    Reset OCM to default values.\n"
+		"  /T    CPU speed benchmark of the current setting.\n"
+		"  /TS   CPU speed benchmark of all the speeds.\n"
+		"  /D    Disk benchmark with the current Turbo MegaSD setting.\n"
+		"  /DS   Disk benchmark with Turbo MegaSD OFF and ON.\n"
+		"        Add the temporary file size in KB (default 128): /D512\n"
+		"  /V    VDP benchmark with the current VDP Speed setting.\n"
+		"  /VS   VDP benchmark with VDP Speed Normal and Fast.\n"
+		"  /M    Memory mapper benchmark and RAM check of the free segments.\n"
+		"  /A    Find the fastest stable custom CPU speed. Add the slots whose\n"
+		"        cartridge must be checked too: /A12\n"
 		"  /Q    Quiet mode (no verbose).\n"
 		"  /?    Show this help.\n"
 		"\n"
@@ -77,14 +94,155 @@ void doResetToDefaults()
 	ocm_sendSmartCmd(OCM_SMART_ResetDefaults);
 }
 
+// The benchmark can't be run
+static void printNoMemory()
+{
+	cprintf("  %s\n", getString(INFO_BENCH_NOMEMORY));
+}
+
+void doCpuBenchmark(bool sweep)
+{
+	BenchCpu_t *results = malloc(sizeof(BenchCpu_t) * BENCHCPU_SPEEDS);
+	uint8_t count = 1;
+
+	cputs(getString(CMD_BENCHCPU));
+	if (!results) {
+		printNoMemory();
+		return;
+	}
+	if (sweep) {
+		bench_cpuSweep(results);
+		count = BENCHCPU_SPEEDS;
+	} else {
+		bench_cpuMeasure(results);
+	}
+	for (uint8_t i = 0; i < count; i++) {
+		bench_cpuFormat(heap_top, &results[i]);
+		cprintf("  %s\n", heap_top);
+	}
+	free(sizeof(BenchCpu_t) * BENCHCPU_SPEEDS);
+}
+
+void doDiskBenchmark(bool sweep, uint16_t sizeKB)
+{
+	BenchDisk_t *results = malloc(sizeof(BenchDisk_t) * 2);
+	uint8_t count = 1;
+
+	cprintf(getString(CMD_BENCHDISK), sizeKB);
+	if (!results) {
+		printNoMemory();
+		return;
+	}
+	if (sweep) {
+		bench_diskSweep(results, sizeKB);
+		count = 2;
+	} else {
+		bench_diskRun(results, sizeKB);
+	}
+	cprintf("  %s\n", getString(INFO_BENCHDISK_HEADER));
+	for (uint8_t i = 0; i < count; i++) {
+		bench_diskFormat(heap_top, &results[i]);
+		cprintf("  %s\n", heap_top);
+	}
+	free(sizeof(BenchDisk_t) * 2);
+}
+
+void doVdpBenchmark(bool sweep)
+{
+	BenchVdp_t *results = malloc(sizeof(BenchVdp_t) * 2);
+	uint8_t kanjiMode = detectKanjiDriver() ? getKanjiMode() : 0;
+	uint8_t count = 1;
+	bool result;
+
+	if (kanjiMode) setKanjiMode(0);
+	if (sweep) {
+		result = bench_vdpSweep(results);
+		count = 2;
+	} else {
+		result = bench_vdpRun(results);
+	}
+	if (kanjiMode) setKanjiMode(kanjiMode);
+
+	cputs(getString(CMD_BENCHVDP));
+	if (!result) {
+		printNoMemory();
+		free(sizeof(BenchVdp_t) * 2);
+		return;
+	}
+	cprintf("  %s\n", getString(INFO_BENCHVDP_HEADER));
+	for (uint8_t i = 0; i < count; i++) {
+		bench_vdpFormat(heap_top, &results[i]);
+		cprintf("  %s\n", heap_top);
+	}
+	free(sizeof(BenchVdp_t) * 2);
+}
+
+void doMapperBenchmark()
+{
+	BenchMapper_t *results = malloc(sizeof(BenchMapper_t));
+
+	cputs(getString(CMD_BENCHMAPPER));
+	if (!results) {
+		printNoMemory();
+		return;
+	}
+	bench_mapperRun(results);
+	if (!results->error) {
+		cprintf("  %s\n", getString(INFO_BENCHMAP_HEADER));
+	}
+	bench_mapperFormat(heap_top, results);
+	cprintf("  %s\n", heap_top);
+	free(sizeof(BenchMapper_t));
+}
+
+void doCpuTune(uint8_t slotMask)
+{
+	BenchTune_t *result = malloc(sizeof(BenchTune_t));
+	uint16_t profile;
+	char key;
+
+	cputs(getString(CMD_BENCHTUNE));
+	if (!result) {
+		printNoMemory();
+		return;
+	}
+	if (!bench_tuneRun(result, slotMask)) {
+		printNoMemory();
+		free(sizeof(BenchTune_t));
+		return;
+	}
+	for (uint8_t i = 0; i < BENCHTUNE_SPEEDS; i++) {
+		bench_tuneFormat(heap_top, result, i);
+		cprintf("  %s\n", heap_top);
+	}
+	bench_tuneFormatBest(heap_top, result);
+	cprintf("%s\n", heap_top);
+
+	if (result->bestCmd) {
+		cputs(getString(CMD_BENCHTUNE_SAVE));
+		key = dos2_toupper(getch());
+		cprintf("%c\n", key);
+		if (key == 'Y') {
+			ocm_sendSmartCmd(result->bestCmd);
+			profile = bench_tuneSaveProfile(result);
+			cprintf(getString(profile ? INFO_BENCHTUNE_SAVED : INFO_BENCHTUNE_NOTSAVED), profile);
+			cputs("\n");
+		}
+	}
+	free(sizeof(BenchTune_t));
+}
+
 void doListProfiles()
 {
-	uint8_t idx = 0;
+	uint16_t idx = 0;
 
 	if (profile_loadFile()) {
 		if (profile_getHeaderData()->itemsCount) {
 			while (item = profile_getItem(idx++)) {
-				cprintf("%u: %s\n", idx, item->description);
+				bench_quickFormat(heap_top, &item->bench);
+				cprintf("%u: %s", idx, item->description);
+				if (*heap_top) cprintf("  [%s]", heap_top);
+				cputs("\n");
 				if (idx % (varCRTCNT-4) == 0) {
 					cputs(getString(CMD_PRESS_A_KEY));
 					getch();
@@ -97,7 +255,7 @@ void doListProfiles()
 	}
 }
 
-bool getProfile(uint8_t idx)
+bool getProfile(uint16_t idx)
 {
 	if (profile_loadFile()) {
 		if (item = profile_getItem(idx-1)) {
@@ -108,7 +266,7 @@ bool getProfile(uint8_t idx)
 	return false;
 }
 
-void doApplyProfile(uint8_t idx)
+void doApplyProfile(uint16_t idx)
 {
 	if (getProfile(idx)) {
 		uint8_t *cmd = item->cmd;
@@ -126,7 +284,7 @@ void doApplyProfile(uint8_t idx)
 	}
 }
 
-void doPrintBTMFile(uint8_t idx)
+void doPrintBTMFile(uint16_t idx)
 {
 	if (getProfile(idx)) {
 		uint8_t *cmd = item->cmd;
@@ -149,6 +307,13 @@ uint16_t commandLine(char **argv, int argc)
 	bool paramDetected = false;
 	bool resetDetected = false;
 	bool btmDetected = false;
+	uint8_t cpuBench = 0;
+	uint8_t diskBench = 0;
+	uint16_t diskSize = BENCHDISK_SIZE_DEFAULT;
+	uint8_t vdpBench = 0;
+	bool mapperBench = false;
+	bool cpuTune = false;
+	uint8_t tuneSlots = 0;
 	uint8_t i = 0;
 	char *arg;
 
@@ -168,6 +333,51 @@ uint16_t commandLine(char **argv, int argc)
 			resetDetected++;
 			showHelp = false;
 		} else
+		if (*arg == 'T') {				// '/T' '/TS'
+			cpuBench = dos2_toupper(arg[1]) == 'S' ? 2 : 1;
+			showHelp = false;
+		} else
+		if (*arg == 'D') {				// '/D[S][k]'
+			diskBench = 1;
+			if (dos2_toupper(*(++arg)) == 'S') {
+				diskBench = 2;
+				arg++;
+			}
+			if (isdigit(*arg)) {
+				diskSize = 0;
+				while (isdigit(*arg) && diskSize <= BENCHDISK_SIZE_MAX) {
+					diskSize = diskSize * 10 + (*arg++ - '0');
+				}
+				diskSize &= ~3;			// Multiple of the 4KB chunks
+				if (*arg || diskSize < 4 || diskSize > BENCHDISK_SIZE_MAX) {
+					cputs(getString(CMD_ERROR_INVALID_SIZE));
+					diskBench = 0;
+					break;
+				}
+			}
+			showHelp = false;
+		} else
+		if (*arg == 'V') {				// '/V' '/VS'
+			vdpBench = dos2_toupper(arg[1]) == 'S' ? 2 : 1;
+			showHelp = false;
+		} else
+		if (*arg == 'A') {				// '/A[slots]'
+			cpuTune = true;
+			while (*(++arg)) {
+				if (*arg < '0' || *arg > '3') {
+					cputs(getString(CMD_ERROR_INVALID_SLOT));
+					cpuTune = false;
+					break;
+				}
+				tuneSlots |= 1 << (*arg - '0');
+			}
+			if (!cpuTune) break;
+			showHelp = false;
+		} else
+		if (*arg == 'M') {				// '/M'
+			mapperBench = true;
+			showHelp = false;
+		} else
 		if (*arg =='Q') {				// '/Q'
 			if (!listProfiles) {
 				verbose = false;
@@ -216,16 +426,32 @@ uint16_t commandLine(char **argv, int argc)
 		if (resetDetected) {
 			doResetToDefaults();
 		}
+		if (cpuBench) {
+			doCpuBenchmark(cpuBench == 2);
+		}
+		if (diskBench) {
+			doDiskBenchmark(diskBench == 2, diskSize);
+		}
+		if (vdpBench) {
+			doVdpBenchmark(vdpBench == 2);
+		}
+		if (mapperBench) {
+			doMapperBenchmark();
+		}
+		if (cpuTune) {
+			doCpuTune(tuneSlots);
+		}
 		if (listProfiles) {
 			doListProfiles();
 		} else
 		if (profileToApply) {
 			if (!btmDetected) {
-				doApplyProfile((uint8_t)profileToApply);
+				doApplyProfile(profileToApply);
 			} else {
-				doPrintBTMFile((uint8_t)profileToApply);
+				doPrintBTMFile(profileToApply);
 			}
 		}
+		profile_release();
 	}
 
 	return 1;
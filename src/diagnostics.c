@@ -0,0 +1,62 @@
+/*
+	Copyright (c) 2024 Natalia Pujol Cremades
+	info@abitwitches.com
+
+	See LICENSE file.
+*/
+#pragma opt_code_size
+#include <stdint.h>
+#include "msx_const.h"
+#include "heap.h"
+#include "diagnostics.h"
+#include "strings_index.h"
+
+
+// ========================================================
+uint16_t diag_values[DIAG_COUNT];
+
+static uint8_t *heapBase;
+static uint16_t lastIdleJiffy;
+
+
+// ========================================================
+/**
+ * @brief Sets the heap base for the heap counters.
+ * Must be called once the final heap_top is set, before any malloc().
+ */
+void diag_init()
+{
+	heapBase = heap_peak = heap_top;
+	diag_values[DIAG_STRINGS] = STRINGS_BIN_SIZE;
+}
+
+/**
+ * @brief Starts the VBLANK overruns check of the main loop idle wait.
+ */
+void diag_idleBegin()
+{
+	lastIdleJiffy = varJIFFY;
+}
+
+/**
+ * @brief Called after each waitVBLANK() of the idle wait: counts an overrun
+ * when more than one frame passed since the previous one.
+ */
+void diag_idleFrame()
+{
+	uint16_t jiffy = varJIFFY;
+	if (jiffy - lastIdleJiffy > 1) {
+		diag_values[DIAG_OVERRUNS]++;
+	}
+	lastIdleJiffy = jiffy;
+}
+
+/**
+ * @brief Updates the computed counters (heap usage).
+ */
+void diag_update()
+{
+	diag_values[DIAG_HEAPUSED] = heap_top - heapBase;
+	diag_values[DIAG_HEAPPEAK] = heap_peak - heapBase;
+	diag_values[DIAG_HEAPFREE] = varTPALIMIT - (uint16_t)heap_top;
+}
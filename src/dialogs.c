@@ -11,8 +11,10 @@
 #include "dialogs.h"
 #include "heap.h"
 #include "conio.h"
+#include "blit80.h"
 #include "utils.h"
 #include "globals.h"
+#include "perf.h"
 
 
 // ========================================================
@@ -20,7 +22,7 @@
 static void _fillBlink(uint8_t x, uint8_t y, uint8_t lines, uint8_t len, bool enabled)
 {
 	while (lines--) {
-		textblink(x, y++, len, enabled);
+		blit80_blink(x, y++, len, enabled);
 	}
 }
 
@@ -36,6 +38,9 @@ uint8_t showDialog(Dialog_t *dlg)
 	uint8_t key, i, auxX, auxY;
 	bool end = false;
 
+	// Drawing & restoring are measured, waiting for the user is not
+	PERF_BEGIN(PERF_SHOWDIALOG);
+
 	// Calculate dialog sizes
 	for (numLines=0; numLines<DLG_MAX_TXT; numLines++) {
 		if (dlg->text[numLines] == ARRAYEND) break;
@@ -68,31 +73,32 @@ uint8_t showDialog(Dialog_t *dlg)
 	char *scrBackup = malloc(dlgBytes);
 
 	// Draw dialog
-	gettext(dx1,dy1, dx2,dy2, scrBackup);				// Backup rectangle chars
+	blit80_gettext(dx1,dy1, dx2,dy2, scrBackup);				// Backup rectangle chars
 
 	memset(heap_top, ' ', dlgBytes);					// Clear rectangle
-	puttext(dx1,dy1, dx2,dy2, heap_top);
+	blit80_puttext(dx1,dy1, dx2,dy2, heap_top);
 
 	drawFrame(dx1+1,dy1, dx2-1,dy2);					// Draw frame
 	_fillBlink(dx1, dy1, dlgHeight, dx2-dx1+1, true);
 	for (i = 0; i<numLines; i++) {
-		putlinexy(dx1 + (dx2-dx1-linesLen[i])/2 + 1, dy1+i+1, linesLen[i], getString(dlg->text[i]));
+		blit80_putline(dx1 + (dx2-dx1-linesLen[i])/2 + 1, dy1+i+1, linesLen[i], getString(dlg->text[i]));
 	}
 
 	auxX = dx1 + (dx2-dx1-totalBtnLen)/2 + 1;
 	auxY = dy1 + numLines + 2;
 	for (i = 0; i<numBtn; i++) {
-		putlinexy(auxX, auxY, btnLen[i], getString(dlg->buttons[i]));
+		blit80_putline(auxX, auxY, btnLen[i], getString(dlg->buttons[i]));
 		btnX[i] = auxX;
 		auxX += btnLen[i];
 		auxX++;
 	}
 
 	// Dialog loop
-	textblink(btnX[selectedBtn],auxY, btnLen[selectedBtn], false);
+	blit80_blink(btnX[selectedBtn],auxY, btnLen[selectedBtn], false);
+	PERF_END(PERF_SHOWDIALOG);
 	while (!end) {
 		while (!kbhit()) { waitVBLANK(); }
-		textblink(btnX[selectedBtn],auxY, btnLen[selectedBtn], true);
+		blit80_blink(btnX[selectedBtn],auxY, btnLen[selectedBtn], true);
 		key = getch();
 		if (dlg->buttons[0] == 0) {
 			end++;
@@ -111,16 +117,18 @@ uint8_t showDialog(Dialog_t *dlg)
 		if (key == KEY_ENTER || key == KEY_SELECT || key == KEY_SPACE) {
 			end++;
 		}
-		textblink(btnX[selectedBtn],auxY, btnLen[selectedBtn], false);
+		blit80_blink(btnX[selectedBtn],auxY, btnLen[selectedBtn], false);
 		varPUTPNT = varGETPNT;
 		varREPCNT = 0;
 	}
 
 	// Restore background
 	waitVBLANK();
+	PERF_BEGIN(PERF_SHOWDIALOG);
 	_fillBlink(dx1, dy1, dlgHeight, dx2-dx1+1, false);
-	puttext(dx1,dy1, dx2,dy2, scrBackup);
+	blit80_puttext(dx1,dy1, dx2,dy2, scrBackup);
 	free(dlgBytes);
+	PERF_END(PERF_SHOWDIALOG);
 
 	return selectedBtn;
 }
\ No newline at end of file
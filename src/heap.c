@@ -9,10 +9,14 @@
 #include "msx_const.h"
 
 
+uint8_t *heap_peak;
+
+
 void *malloc(uint16_t size) {
 	if ((uint16_t)heap_top + size >= varTPALIMIT) return 0x0000;
 	uint8_t *ret = heap_top;
 	heap_top += size;
+	if (heap_top > heap_peak) heap_peak = heap_top;
 	return (void*)ret;
 }
 
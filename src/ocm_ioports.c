@@ -5,6 +5,7 @@
 	See LICENSE file.
 */
 #include "ocm_ioports.h"
+#include "diagnostics.h"
 
 
 bool ocm_detectDevice(uint8_t devId) __naked __z88dk_fastcall
@@ -66,6 +67,10 @@ uint8_t ocm_getPortValue(uint8_t port) __naked __z88dk_fastcall
 {
 	port;								// L = Param port
 	__asm
+		ld   de, (_diag_values+0)		; diag_values[DIAG_PORTREADS]++
+		inc  de
+		ld   (_diag_values+0), de
+
 		in   a, (0x40)					; backup current manufacturer/device
 		cpl
 		push af
@@ -87,6 +92,10 @@ uint16_t ocm_getDynamicPortValue(uint8_t index) __naked __z88dk_fastcall
 {
 	index;
 	__asm
+		ld   de, (_diag_values+0)		; diag_values[DIAG_PORTREADS]++
+		inc  de
+		ld   (_diag_values+0), de
+
 		in   a, (0x40)					; backup current manufacturer/device
 		cpl
 		push af
@@ -118,6 +127,10 @@ bool ocm_sendSmartCmd(uint8_t cmd) __naked __z88dk_fastcall
 {
 	cmd;								// L = Param cmd
 	__asm
+		ld   de, (_diag_values+2)		; diag_values[DIAG_SMARTCMDS]++
+		inc  de
+		ld   (_diag_values+2), de
+
 		in a, (0x40)					; backup current manufacturer/device
 		cpl
 		push af
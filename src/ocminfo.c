@@ -11,6 +11,7 @@
 #include "dos.h"
 #include "globals.h"
 #include "dialogs.h"
+#include "blit80.h"
 #include "profiles_ui.h"
 #include "profiles_api.h"
 #include "heap.h"
@@ -18,6 +19,13 @@
 #include "ocm_ioports.h"
 #include "ocminfo.h"
 #include "patterns.h"
+#include "perf.h"
+#include "diagnostics.h"
+#include "bench_cpu.h"
+#include "bench_disk.h"
+#include "bench_vdp.h"
+#include "bench_mapper.h"
+#include "bench_tune.h"
 
 
 // ========================================================
@@ -57,6 +65,8 @@ static Panel_t *currentPanel;
 static Element_t *currentElement;
 static Element_t *nextElement;
 static Panel_t *nextPanel;
+static uint16_t diagShadow[DIAG_COUNT];
+static uint16_t availKey = 0xffff;		// I/O revision & machine type of the availability bitmaps
 
 
 // ========================================================
@@ -69,9 +79,12 @@ void _copyRAMtoVRAM(uint16_t memory, uint16_t vram, uint16_t size) __sdcccall(0)
 
 void abortRoutine();
 void restoreScreen();
-bool sendCommand(Element_t *elem);
+static void updateAvailability();
+bool sendCommand(Element_t *elem, ElementInfo_t *info);
 static void drawCurrentPanel();
 static bool drawElement(Element_t *element);
+static void selectPanel(Panel_t *panel);
+static void initScreen();
 
 
 // ========================================================
@@ -145,13 +158,15 @@ void abortRoutine()
 
 void putstrxy(uint8_t x, uint8_t y, char *str)
 {
-	putlinexy(x, y, strlen(str), str);
+	blit80_putline(x, y, strlen(str), str);
 }
 
 
 // ========================================================
 static uint8_t getOcmData()
 {
+	PERF_BEGIN(PERF_GETOCMDATA);
+
 	// Hardware ports values
 	virtualDIPs.raw = ocm_getPortValue(OCM_VIRTDIPS_PORT);
 	lockToggles.raw = ocm_getPortValue(OCM_LOCKTOGG_PORT);
@@ -191,6 +206,10 @@ static uint8_t getOcmData()
 					audioVols1.raw ^ sysInfo0.raw ^ sysInfo1.raw ^ sysInfo2.raw ^ sysInfo3.raw ^ 
 					sysInfo4_0.raw ^ sysInfo4_1.raw ^ sysInfo4_2.raw ^ sysInfo5.raw ^ 
 					pldVers0.raw ^ pldVers1.raw;
+
+	updateAvailability();
+
+	PERF_END(PERF_GETOCMDATA);
 	return portsChecksum;
 }
 
@@ -208,7 +227,7 @@ static void printHeader()
 			sysInfo4_0.sdramSize != 3 ? sdramSizeStr[sysInfo4_0.sdramSize] : sdramSizeAuxStr[sysInfo4_1.sdramSizeAux]
 	);
 
-	textblink(1,1, 80, true);
+	blit80_blink(1,1, 80, true);
 
 	csprintf(heap_top, getString(HEADER_MODEL_SDRAM),
 		getString(machineTypeStr[pldVers1.ioRevision < IOREV_4 ? MACHINETYPE_UNKNOWN : sysInfo2.machineTypeId]), 
@@ -230,7 +249,9 @@ static void printHeader()
 	drawFrame(1,2, 80,24);
 	Panel_t *panel = &pPanels[PANEL_FIRST];
 	while (panel->title != ARRAYEND) {
-		putlinexy(panel->titlex,panel->titley, panel->titlelen, getString(panel->title));
+		if (panel->titley) {
+			blit80_putline(panel->titlex,panel->titley, panel->titlelen, getString(panel->title));
+		}
 		panel++;
 	}
 
@@ -243,7 +264,7 @@ static void printHeader()
 	// Version
 	csprintf(heap_top, getString(HEADER_NAME), getString(HEADER_VERSION));
 	uint16_t verLen = strlen(heap_top);
-	putlinexy(78-verLen, 24, verLen, heap_top);
+	blit80_putline(78-verLen, 24, verLen, heap_top);
 }
 
 static void drawDescription(uint16_t *description)
@@ -251,7 +272,7 @@ static void drawDescription(uint16_t *description)
 	waitVBLANK();
 
 	// Clear Description zone
-	puttext(2,21, 79,23, emptyArea);
+	blit80_puttext(2,21, 79,23, emptyArea);
 
 	// Print new Description
 	for (uint8_t i = 0; i < ELEMENT_MAX_DESC ; i++) {
@@ -260,44 +281,130 @@ static void drawDescription(uint16_t *description)
 	}
 }
 
+// Benchmark results area: the benchmark can't be run
+static void drawNoMemory()
+{
+	blit80_puttext(2,21, 79,23, emptyArea);
+	putstrxy(3,21, getString(INFO_BENCH_NOMEMORY));
+}
+
 static void drawSetSmartText()
 {
 	if (lastCmdSent != OCM_SMART_NullCommand) {
 		csprintf(heap_top, getString(INFO_SETSMART_CMD), lastCmdSent/16, lastCmdSent%16);
-		putlinexy(SETSMART_X,SETSMART_Y, SETSMART_SIZE, heap_top);
+		blit80_putline(SETSMART_X,SETSMART_Y, SETSMART_SIZE, heap_top);
 		isVisibleSetSmartText = true;
 	}
 }
 
 
 // ========================================================
-bool isIOrevisionSupported(Element_t *element)
+// Index of an element of the current panel
+static uint8_t getIndex(Element_t *element)
+{
+	return ((uint16_t)element - (uint16_t)currentPanel->elements) / sizeof(Element_t);
+}
+
+// Cold fields of an element of the current panel
+static ElementInfo_t* getInfo(Element_t *element)
 {
-	return pldVers1.ioRevision >= element->ioRevNeeded;
+	return &currentPanel->infos[getIndex(element)];
 }
 
-bool isMachineSupported(Element_t *element)
+bool isIOrevisionSupported(ElementInfo_t *info)
 {
-	return ((1<<sysInfo2.machineTypeId) & element->supportedBy) != 0;
+	return pldVers1.ioRevision >= info->ioRevNeeded;
 }
 
+bool isMachineSupported(ElementInfo_t *info)
+{
+	return ((1<<sysInfo2.machineTypeId) & info->supportedBy) != 0;
+}
 
-// ========================================================
-static uint8_t getValueOffset(uint8_t mask)
+static bool isAvailable(Panel_t *panel, uint8_t index)
+{
+	return (panel->avail[index >> 3] & (1 << (index & 7))) != 0;
+}
+
+static void setAvailable(Panel_t *panel, uint8_t index, bool available)
+{
+	uint8_t *avail = &panel->avail[index >> 3];
+	uint8_t bit = 1 << (index & 7);
+
+	if (available) {
+		*avail |= bit;
+	} else {
+		*avail &= ~bit;
+	}
+}
+
+/**
+ * @brief Rebuilds the availability bitmaps of all the panels when the I/O
+ * revision or the machine type change, and applies the dynamic rules.
+ */
+static void updateAvailability()
 {
-	uint8_t offset = 0;
-	if (mask) {
-		while ((mask & 1) == 0) {
-			offset++;
-			mask >>= 1;
+	uint16_t key = (pldVers1.ioRevision << 8) | sysInfo2.machineTypeId;
+	Panel_t *panel = &pPanels[PANEL_FIRST];
+	Element_t *element;
+	ElementInfo_t *info;
+	uint8_t *avail, bit;
+
+	if (key != availKey) {
+		availKey = key;
+		while (panel->title != ARRAYEND) {
+			element = panel->elements;
+			info = panel->infos;
+			avail = panel->avail;
+			panel++;
+			if (element == NULL) continue;
+			*avail = 0;
+			bit = 1;
+			while (element->type != END) {
+				if (isIOrevisionSupported(info) && isMachineSupported(info)) {
+					*avail |= bit;
+				}
+				if (!(bit <<= 1)) {
+					bit = 1;
+					*++avail = 0;
+				}
+				element++;
+				info++;
+			}
 		}
 	}
-	return offset;
+
+	// 'Custom speed' is only available with a custom CPU clock
+	info = &elemSystemInfo[CUSTOM_SPEED_IDX];
+	setAvailable(&pPanels[PANEL_SYSTEM], CUSTOM_SPEED_IDX,
+		virtualDIPs.cpuClock && isIOrevisionSupported(info) && isMachineSupported(info));
+}
+
+/**
+ * @brief Follows a navigation offset from the current element skipping the
+ * unavailable elements.
+ * @param dir Offset of the goXXX field from goUp (0:up 1:down 2:left 3:right)
+ * @return The new element, or the current one if none is available
+ */
+static Element_t* getNavigationTarget(uint8_t dir)
+{
+	Element_t *element = currentElement;
+	int8_t offset;
+
+	for (uint8_t i = 0; i < PANELS_MAX_ELEMENTS; i++) {
+		offset = (&element->goUp)[dir];
+		if (!offset) break;
+		element += offset;
+		if (isAvailable(currentPanel, getIndex(element))) return element;
+	}
+	return currentElement;
 }
 
+
+// ========================================================
 static void setValue(Element_t *elem, uint8_t value)
 {
-	value <<= getValueOffset(elem->valueMask);
+	value <<= elem->valueShift;
 	value &= elem->valueMask;
 
 	*elem->value &= ~(elem->valueMask);
@@ -306,13 +413,15 @@ static void setValue(Element_t *elem, uint8_t value)
 
 static uint8_t getValue(Element_t *elem)
 {
-	return (*(elem->value) & elem->valueMask) >> getValueOffset(elem->valueMask);
+	return (*(elem->value) & elem->valueMask) >> elem->valueShift;
 }
 
 static bool changeCurrentValue(int8_t increase)
 {
-	if (!isIOrevisionSupported(currentElement) || 
-		!isMachineSupported(currentElement) ||
+	uint8_t index = getIndex(currentElement);
+	ElementInfo_t *info = &currentPanel->infos[index];
+
+	if (!isAvailable(currentPanel, index) ||
 		currentElement->cmdType == CMDTYPE_NONE ||
 		currentElement->value == NULL)
 	{
@@ -326,12 +435,12 @@ static bool changeCurrentValue(int8_t increase)
 	if (currentElement->cmdType != CMDTYPE_NONE) {		// if is RW
 		setValue(currentElement, value);
 		
-		if (sendCommand(currentElement)) {
+		if (sendCommand(currentElement, info)) {
 			// Display setsmart text
 			drawSetSmartText();
 		} else {
 			// Element disabled
-			currentElement->supportedBy = M_NONE;
+			setAvailable(currentPanel, index, false);
 			return false;
 		}
 		return true;
@@ -340,9 +449,11 @@ static bool changeCurrentValue(int8_t increase)
 }
 
 // ========================================================
-uint8_t getActiveCommand(Element_t *elem)
+uint8_t getActiveCommand(Element_t *elem, ElementInfo_t *info)
 {
-	uint8_t elemCmd = elem->cmd[getValue(elem)];
+	if (info->cmd == NULL) return OCM_SMART_NullCommand;
+
+	uint8_t elemCmd = info->cmd[getValue(elem)];
 
 	// Single Standard Command
 	if (elem->cmdType == CMDTYPE_STANDARD) {
@@ -352,20 +463,20 @@ uint8_t getActiveCommand(Element_t *elem)
 	if (elem->cmdType == CMDTYPE_CUSTOM_CPUMODE) {
 		// If custom cpu speed then set the current custom speed directly
 		if (elemCmd == OCM_SMART_NullCommand) {
-			return elemSystem[CUSTOM_SPEED_IDX].cmd[sysInfo0.cpuCustomSpeed];
+			return elemSystemInfo[CUSTOM_SPEED_IDX].cmd[sysInfo0.cpuCustomSpeed];
 		}
 		return elemCmd;
 	} else
 	if (elem->cmdType == CMDTYPE_CUSTOM_SLOTS12) {
-		return elem->cmd[customSlots12Value];
+		return info->cmd[customSlots12Value];
 	}
 
 	return OCM_SMART_NullCommand;
 }
 
-bool sendCommand(Element_t *elem)
+bool sendCommand(Element_t *elem, ElementInfo_t *info)
 {
-	uint8_t cmd = getActiveCommand(elem);
+	uint8_t cmd = getActiveCommand(elem, info);
 	lastCmdSent = cmd;
 
 	// Send Command
@@ -385,23 +496,27 @@ void getPanelsCmds(uint8_t *cmd)
 
 	Panel_t *panel = &pPanels[PANEL_FIRST];
 	Element_t *element;
+	ElementInfo_t *info;
+	uint8_t *avail, bit;
 	uint8_t *lastCmds = malloc(LASTCMDS_SIZE), *lastPtr;
 	uint8_t *ptr = cmd, cmdToAdd;
 	uint8_t cmdCount = 0;
 
+	updateAvailability();
+
 	*cmd = 0x00;
 	while (panel->title != ARRAYEND) {
 		element = panel->elements;
+		info = panel->infos;
+		avail = panel->avail;
 		panel++;
 		if (element == NULL) continue;
 		lastPtr = lastCmds;
 		*lastCmds = 0x00;
+		bit = 1;
 		while (element->type != END) {
-			if (element->saveToProfile && 
-				isMachineSupported(element) && 
-				isIOrevisionSupported(element))
-			{
-				cmdToAdd = getActiveCommand(element);
+			if (element->saveToProfile && (*avail & bit)) {
+				cmdToAdd = getActiveCommand(element, info);
 				if (cmdToAdd != OCM_SMART_NullCommand) {
 					if (element->sendSmartLast) {
 						// Add command to lastCmds (check bounds)
@@ -421,7 +536,12 @@ void getPanelsCmds(uint8_t *cmd)
 					}
 				}
 			}
+			if (!(bit <<= 1)) {
+				bit = 1;
+				avail++;
+			}
 			element++;
+			info++;
 		}
 		// Dump elements with sendSmartLast enabled
 		if (*lastCmds) {
@@ -443,7 +563,7 @@ void getPanelsCmds(uint8_t *cmd)
 
 
 // ========================================================
-static void drawWidget_slider(Element_t *element)
+static void drawWidget_slider(Element_t *element, ElementInfo_t *info)
 {
 	uint8_t posx = wherex();
 	char sliderStr[] = "\x81\x81\x81\x81\x81\x81\x81\x81\x81";
@@ -451,68 +571,74 @@ static void drawWidget_slider(Element_t *element)
 
 	sliderStr[element->maxValue - element->minValue + 1] = '\0';
 	sliderStr[value - element->minValue] = '\x83';
-	if (element->valueStr != NULL) {
-		csprintf(heap_top, "-\x80%s\x82+  %s", sliderStr, getString(element->valueStr[value]));
+	if (info->valueStr != NULL) {
+		csprintf(heap_top, "-\x80%s\x82+  %s", sliderStr, getString(info->valueStr[value]));
 	} else {
 		csprintf(heap_top, "-\x80%s\x82+  %u  ", sliderStr, value);
 	}
 	putstrxy(posx, wherey(), heap_top);
 }
 
-static void drawWidget_value(Element_t *element)
+static void drawWidget_value(Element_t *element, ElementInfo_t *info)
 {
 	uint8_t value = getValue(element);
-	if (element->valueStr == NULL) {
+	if (info->valueStr == NULL) {
 		csprintf(heap_top, "%u", value);
 	} else {
-		csprintf(heap_top, "%s", getString(element->valueStr[value]));
+		csprintf(heap_top, "%s", getString(info->valueStr[value]));
 	}
 	putstrxy(wherex() + element->maxValue, wherey(), heap_top);
 }
 
-static void drawCustom_cpuSpeed(Element_t *element)
+static void drawCustom_cpuSpeed(Element_t *element, ElementInfo_t *info)
 {
-	Element_t *elemChange = &currentPanel->elements[3];
+	Element_t *elemChange = &currentPanel->elements[CUSTOM_SPEED_IDX];
 	if (!virtualDIPs.cpuClock) {
-		// Standard / TurboPana speed
-		elemChange->supportedBy = M_NONE;		// Element 'Custom speed' disabled
-		putlinexy(elemChange->posX + strlen(getString(elemChange->label)), elemChange->posY, 12, emptyArea);
-	} else {
-		// Custom speed
-		elemChange->supportedBy = M_ALL;		// Element 'Custom speed' enabled
+		// Standard / TurboPana speed: 'Custom speed' is not available
+		blit80_putline(elemChange->posX + currentPanel->infos[CUSTOM_SPEED_IDX].labelLen, elemChange->posY, 12, emptyArea);
 	}
-	drawWidget_value(element);
+	drawWidget_value(element, info);
 }
 
-static void drawCustom_volume(Element_t *element)
+static void drawCustom_volume(Element_t *element, ElementInfo_t *info)
 {
-	drawWidget_slider(element);
+	drawWidget_slider(element, info);
 	if (currentElement == element) {
 		customAudioPresetValue = 0;
 		drawElement(&elemAudio[0]);
 	}
 }
 
+static void drawCustom_diagValue(Element_t *element)
+{
+	uint16_t value = *((uint16_t*)element->value);
+	diagShadow[(uint16_t*)element->value - diag_values] = value;
+	csprintf(heap_top, "%u    ", value);
+	putstrxy(wherex(), wherey(), heap_top);
+}
+
 static bool drawElement(Element_t *element)
 {
 	if (element->type == END) return false;
 
-	uint8_t posx = element->posX;
-	uint8_t posy = element->posY;
-
-	putstrxy(posx, posy, getString(element->label));
-
+	// Labels are drawn by the panel static label layer
 	if (element->type == LABEL) return true;
 
-	posx += element->valueOffsetX;
-	if (!isIOrevisionSupported(element) || !isMachineSupported(element)) {
-		char *text = getString(element->useLastStrForNA ? element->valueStr[element->maxValue+1] : LABEL_NA);
-		putlinexy(posx, posy, element->maxValue + 6, emptyArea);
+	PERF_BEGIN(PERF_DRAWELEMENT);
+	uint8_t index = getIndex(element);
+	ElementInfo_t *info = &currentPanel->infos[index];
+	uint8_t posx = element->valueX;
+	uint8_t posy = element->posY;
+
+	if (!isAvailable(currentPanel, index)) {
+		char *text = getString(element->useLastStrForNA ? info->valueStr[element->maxValue+1] : LABEL_NA);
+		blit80_putline(posx, posy, element->maxValue + 6, emptyArea);
 		putstrxy(
 			posx + element->maxValue + 7,
 			posy,
 			text
 		);
+		PERF_END(PERF_DRAWELEMENT);
 		return true;
 	}
 
@@ -524,30 +650,205 @@ static bool drawElement(Element_t *element)
 		case BUTTON:
 			break;
 		case VALUE:
-			drawWidget_value(element);
+			drawWidget_value(element, info);
 			break;
 		case SLIDER:
-			drawWidget_slider(element);
+			drawWidget_slider(element, info);
 			break;
 		case CUSTOM_CPUCLOCK_VALUE:
-			drawCustom_cpuSpeed(element);
+			drawCustom_cpuSpeed(element, info);
 			break;
 		case CUSTOM_VOLUME_SLIDER:
-			drawCustom_volume(element);
+			drawCustom_volume(element, info);
+			break;
+		case CUSTOM_DIAG_VALUE:
+			drawCustom_diagValue(element);
 			break;
 	}
+	PERF_END(PERF_DRAWELEMENT);
 	return true;
 }
 
 static void selectCurrentElement(bool enable)
 {
-	textblink(
+	ElementInfo_t *info = getInfo(currentElement);
+
+	blit80_blink(
 		currentElement->posX, currentElement->posY,
-		strlen(getString(currentElement->label)),
+		info->labelLen,
 		enable);
 	if (enable) {
-		drawDescription(currentElement->description);
+		drawDescription(info->description);
+	}
+}
+
+inline bool isShiftKeyPressed()
+{
+	return varNEWKEY_row6.shift == 0;
+}
+
+static bool runCpuBenchmark()
+{
+	static const uint16_t runningStr[] = { DESC_BENCH_CPU_RUNNING, ARRAYEND };
+	BenchCpu_t *results = malloc(sizeof(BenchCpu_t) * BENCHCPU_SPEEDS);
+
+	if (!results) {
+		drawNoMemory();
+		return false;
+	}
+	drawDescription(runningStr);
+	if (isShiftKeyPressed()) {
+		bench_cpuSweep(results);
+		getOcmData();
+
+		// 3 results per line
+		blit80_puttext(2,21, 79,23, emptyArea);
+		for (uint8_t i = 0; i < BENCHCPU_SPEEDS; i++) {
+			bench_cpuFormat(heap_top, &results[i]);
+			putstrxy(3 + (i % 3) * 26, 21 + i / 3, heap_top);
+		}
+	} else {
+		bench_cpuMeasure(results);
+
+		blit80_puttext(2,21, 79,23, emptyArea);
+		putstrxy(3,21, getString(INFO_BENCHCPU_CURRENT));
+		bench_cpuFormat(heap_top, results);
+		putstrxy(3,22, heap_top);
+	}
+	free(sizeof(BenchCpu_t) * BENCHCPU_SPEEDS);
+	return true;
+}
+
+static bool runDiskBenchmark()
+{
+	static const uint16_t runningStr[] = { DESC_BENCH_DISK_RUNNING, ARRAYEND };
+	BenchDisk_t *results = malloc(sizeof(BenchDisk_t) * 2);
+	uint8_t count = 1;
+	bool result = true;
+
+	if (!results) {
+		drawNoMemory();
+		return false;
 	}
+	drawDescription(runningStr);
+	if (isShiftKeyPressed()) {
+		bench_diskSweep(results, BENCHDISK_SIZE_DEFAULT);
+		getOcmData();
+		count = 2;
+	} else {
+		bench_diskRun(results, BENCHDISK_SIZE_DEFAULT);
+	}
+
+	// Results table
+	blit80_puttext(2,21, 79,23, emptyArea);
+	putstrxy(3,21, getString(INFO_BENCHDISK_HEADER));
+	for (uint8_t i = 0; i < count; i++) {
+		bench_diskFormat(heap_top, &results[i]);
+		putstrxy(3, 22 + i, heap_top);
+		if (results[i].error) result = false;
+	}
+	free(sizeof(BenchDisk_t) * 2);
+	return result;
+}
+
+static bool runVdpBenchmark()
+{
+	BenchVdp_t *results = malloc(sizeof(BenchVdp_t) * 2);
+	Element_t *element = currentElement;
+	uint8_t count = 1;
+	bool result;
+
+	if (isShiftKeyPressed()) {
+		result = bench_vdpSweep(results);
+		count = 2;
+	} else {
+		result = bench_vdpRun(results);
+	}
+	if (!result) {
+		drawNoMemory();
+		free(sizeof(BenchVdp_t) * 2);
+		return false;
+	}
+
+	// The VRAM was used by the benchmark: redraw everything
+	initScreen();
+	printHeader();
+	selectPanel(currentPanel);
+	selectCurrentElement(false);
+	currentElement = nextElement = element;
+	selectCurrentElement(true);
+
+	// Results table
+	blit80_puttext(2,21, 79,23, emptyArea);
+	putstrxy(3,21, getString(INFO_BENCHVDP_HEADER));
+	for (uint8_t i = 0; i < count; i++) {
+		bench_vdpFormat(heap_top, &results[i]);
+		putstrxy(3, 22 + i, heap_top);
+	}
+	free(sizeof(BenchVdp_t) * 2);
+	return true;
+}
+
+static bool runMapperBenchmark()
+{
+	static const uint16_t runningStr[] = { DESC_BENCH_MAPPER_RUNNING, ARRAYEND };
+	BenchMapper_t *results = malloc(sizeof(BenchMapper_t));
+	bool result;
+
+	if (!results) {
+		drawNoMemory();
+		return false;
+	}
+	drawDescription(runningStr);
+	result = bench_mapperRun(results);
+
+	blit80_puttext(2,21, 79,23, emptyArea);
+	if (!results->error) {
+		putstrxy(3,21, getString(INFO_BENCHMAP_HEADER));
+	}
+	bench_mapperFormat(heap_top, results);
+	putstrxy(3,22, heap_top);
+	free(sizeof(BenchMapper_t));
+	return result;
+}
+
+static bool runCpuTune()
+{
+	static const uint16_t runningStr[] = { DESC_BENCH_TUNE_RUNNING, ARRAYEND };
+	BenchTune_t *result = malloc(sizeof(BenchTune_t));
+	uint16_t profile;
+	bool found;
+
+	if (!result) {
+		drawNoMemory();
+		return false;
+	}
+	drawDescription(runningStr);
+	if (!bench_tuneRun(result, isShiftKeyPressed() ? 0b00000110 : 0)) {	// Slots 1 and 2
+		drawNoMemory();
+		free(sizeof(BenchTune_t));
+		return false;
+	}
+	found = result->bestCmd != 0;
+
+	// 4 speeds per line and the fastest stable one
+	blit80_puttext(2,21, 79,23, emptyArea);
+	for (uint8_t i = 0; i < BENCHTUNE_SPEEDS; i++) {
+		bench_tuneFormat(heap_top, result, i);
+		putstrxy(3 + (i % 4) * 19, 21 + i / 4, heap_top);
+	}
+	bench_tuneFormatBest(heap_top, result);
+	putstrxy(3,23, heap_top);
+
+	if (found && showDialog(&dlg_tune) == BTN_YES) {
+		ocm_sendSmartCmd(result->bestCmd);
+		profile = bench_tuneSaveProfile(result);
+		csprintf(heap_top, getString(profile ? INFO_BENCHTUNE_SAVED : INFO_BENCHTUNE_NOTSAVED), profile);
+		putstrxy(42,23, heap_top);
+	}
+	getOcmData();
+	free(sizeof(BenchTune_t));
+	return found;
 }
 
 static void pressedCurrentElement(uint8_t increment)
@@ -561,8 +862,23 @@ static void pressedCurrentElement(uint8_t increment)
 	}
 
 	if (commandToSend) {
+		if (currentElement->cmdType == CMDTYPE_CUSTOM_BENCHCPU) {
+			changeResult = runCpuBenchmark();
+		} else
+		if (currentElement->cmdType == CMDTYPE_CUSTOM_BENCHDISK) {
+			changeResult = runDiskBenchmark();
+		} else
+		if (currentElement->cmdType == CMDTYPE_CUSTOM_BENCHVDP) {
+			changeResult = runVdpBenchmark();
+		} else
+		if (currentElement->cmdType == CMDTYPE_CUSTOM_BENCHMAPPER) {
+			changeResult = runMapperBenchmark();
+		} else
+		if (currentElement->cmdType == CMDTYPE_CUSTOM_BENCHTUNE) {
+			changeResult = runCpuTune();
+		} else
 		if (currentElement->type == BUTTON) {
-			changeResult = sendCommand(currentElement);
+			changeResult = sendCommand(currentElement, getInfo(currentElement));
 			drawSetSmartText();
 		} else {
 			changeResult = changeCurrentValue(increment);
@@ -590,29 +906,62 @@ static void pressedCurrentElement(uint8_t increment)
 }
 
 // ========================================================
+static void drawLabelLayer()
+{
+	PanelLabel_t *label = currentPanel->labels;
+	while (label->len) {
+		blit80_putvram(label->vram, label->len, getString(label->label));
+		label++;
+	}
+}
+
 static void drawCurrentPanel()
 {
+	uint16_t startJiffy = varJIFFY;
 	Element_t *element = &(currentPanel->elements[0]);
+	drawLabelLayer();
 	while (drawElement(element)) {
 		element++;
 	}
+	diag_values[DIAG_REDRAWFRAMES] = varJIFFY - startJiffy;
+}
+
+// Redraws only the diagnostics counters that changed since the last frame
+static void refreshDiagPanel()
+{
+	Element_t *element = &(currentPanel->elements[0]);
+
+	diag_update();
+	while (element->type != END) {
+		if (element->type == CUSTOM_DIAG_VALUE &&
+			*((uint16_t*)element->value) != diagShadow[(uint16_t*)element->value - diag_values])
+		{
+			drawElement(element);
+		}
+		element++;
+	}
 }
 
 static void selectPanelTitle(Panel_t *panel)
 {
 	if (currentPanel != NULL) {
-		textblink(1, panel->titley, 80, false);
+		blit80_blink(1, pPanels[PANEL_FIRST].titley, 80, false);
 		selectCurrentElement(false);
 	}
 
-	// Set title blink
-	textblink(panel->titlex, panel->titley, panel->titlelen, true);
+	// Set title blink (hidden panels have no title)
+	if (panel->titley) {
+		blit80_blink(panel->titlex, panel->titley, panel->titlelen, true);
+	}
 }
 
 static void selectPanel(Panel_t *panel)
 {
+	uint16_t startJiffy = varJIFFY;
+
 	// Refresh I/O ext values
 	getOcmData();
+	diag_update();
 
 	waitVBLANK();
 
@@ -621,7 +970,7 @@ static void selectPanel(Panel_t *panel)
 
 	// Clear Panel zone
 	if (currentPanel != panel) {
-		puttext(2,5, 79,19, emptyArea);
+		blit80_puttext(2,5, 79,19, emptyArea);
 	}
 
 	// Draw Panel elements
@@ -630,7 +979,9 @@ static void selectPanel(Panel_t *panel)
 
 	// Select first element as current
 	currentElement = nextElement = &currentPanel->elements[0];
-	while (currentElement->type != END && currentElement->type == LABEL) {
+	while (currentElement->type != END &&
+		(currentElement->type == LABEL || !isAvailable(currentPanel, getIndex(currentElement))))
+	{
 		currentElement++;
 	}
 	if (currentElement->type == END) {
@@ -641,6 +992,8 @@ static void selectPanel(Panel_t *panel)
 
 	// Set first element selected
 	selectCurrentElement(true);
+
+	diag_values[DIAG_PANELFRAMES] = varJIFFY - startJiffy;
 }
 
 inline void redefineFunctionKeys()
@@ -657,9 +1010,15 @@ inline void redefineCharPatterns()
 	_copyRAMtoVRAM((uint16_t)charPatters, 0x1000+0x7f*8, 5*8);
 }
 
-inline bool isShiftKeyPressed()
+static void initScreen()
 {
-	return varNEWKEY_row6.shift == 0;
+	// Initialize screen 0[80]
+	textmode(BW80);
+	textattr(0xa1f4);
+	setcursortype(NOCURSOR);
+	redefineFunctionKeys();
+	redefineCharPatterns();
+	_fillVRAM(0x0800, 240, 0);			// Clear blink
 }
 
 // ========================================================
@@ -677,15 +1036,12 @@ void menu_panels()
 	//Platform system checks
 	checkPlatformSystem();
 
-	// Load profile file
+	// Load profile file, the store stays resident for the session
+	uint16_t startJiffy = varJIFFY;
 	profile_loadFile();
+	diag_values[DIAG_PROFLOAD] = varJIFFY - startJiffy;
 
-	// Initialize screen 0[80]
-	textmode(BW80);
-	textattr(0xa1f4);
-	setcursortype(NOCURSOR);
-	redefineFunctionKeys();
-	redefineCharPatterns();
+	initScreen();
 
 	// Get data from I/O extension ports
 	getOcmData();
@@ -699,14 +1055,19 @@ void menu_panels()
 	lastExtraKeys = getExtraKeysOCM().raw;
 	currentExtraKeys = lastExtraKeys;
 	do {
+		diag_idleBegin();
 		while (!kbhit() && lastExtraKeys == currentExtraKeys) {
 			waitVBLANK();
+			diag_idleFrame();
 			currentExtraKeys = getExtraKeysOCM().raw;
+			if (currentPanel == &pPanels[PANEL_DIAG]) {
+				refreshDiagPanel();
+			}
 		}
 
 		// Clear last setsmart text
 		if (isVisibleSetSmartText || lastExtraKeys != currentExtraKeys) {
-			putlinexy(SETSMART_X,SETSMART_Y, SETSMART_SIZE, emptyArea);
+			blit80_putline(SETSMART_X,SETSMART_Y, SETSMART_SIZE, emptyArea);
 			isVisibleSetSmartText = false;
 		}
 
@@ -730,16 +1091,16 @@ void menu_panels()
 		// Manage pressed key
 		switch(dos2_toupper(getch())) {
 			case KEY_UP:
-				nextElement = currentElement + currentElement->goUp;
+				nextElement = getNavigationTarget(0);
 				break;
 			case KEY_DOWN:
-				nextElement = currentElement + currentElement->goDown;
+				nextElement = getNavigationTarget(1);
 				break;
 			case KEY_LEFT:
-				nextElement = currentElement + currentElement->goLeft;
+				nextElement = getNavigationTarget(2);
 				break;
 			case KEY_RIGHT:
-				nextElement = currentElement + currentElement->goRight;
+				nextElement = getNavigationTarget(3);
 				break;
 			case KEY_SPACE:
 			case KEY_ENTER:
@@ -768,6 +1129,9 @@ void menu_panels()
 			case 'A':
 				selectPanel(&pPanels[PANEL_HELP]);
 				break;
+			case 'D':
+				selectPanel(&pPanels[PANEL_DIAG]);
+				break;
 			case KEY_TAB:
 				nextPanel = currentPanel;
 				if (!isShiftKeyPressed()) {
@@ -809,6 +1173,7 @@ void menu_panels()
 		varREPCNT = 0;
 	} while (!end);
 
+	profile_release();
 	restoreScreen();
 }
 
@@ -869,9 +1234,12 @@ int main(char **argv, int argc) __sdcccall(0)
 	// A way to avoid using low memory when using BIOS calls from DOS
 	if (heap_top < (void*)0x8000)
 		heap_top = (void*)0x8000;
+	diag_init();
 
 	// Initialize compressed strings
+	PERF_BEGIN(PERF_STRINGSINIT);
 	stringsInit();
+	PERF_END(PERF_STRINGSINIT);
 
 	if (argc != 0) {
 		return commandLine(argv, argc);
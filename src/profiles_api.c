@@ -11,18 +11,87 @@
 #include "conio.h"
 #include "dos.h"
 #include "heap.h"
+#include "globals.h"
 #include "profiles_api.h"
+#include "perf.h"
+
+
+// ========================================================
+// Defines & private types
+
+#define FILE_CLOSED		0xff
+#define SLOTS_BYTES		((PROF_MAX_SLOTS + 7) / 8)
+#define SCAN_RECORDS	8			// Records read at once when scanning the file
+#define COPY_BUFFER		1024		// Bytes read at once when copying the file
+#define ENV_PROFILES	"OCMINFO"			// Profiles file path
+#define ENV_MIRROR		"OCMINFO_MIRROR"	// Working copy path (i.e. RAM disk)
+#define LEGACY_MAX		50			// Profiles limit of the revisions 2 & 3
+#define LEGACY_TMPNAME	"OCMINFO.$$$"	// Converted file until it replaces the legacy one
+#define LEGACY_OLDNAME	"OCMINFO.OLD"	// Legacy file while it's being replaced
+
+enum {								// _migrateLegacyFile results
+	LEGACY_FAILED,
+	LEGACY_CONVERTED,				// File rewritten with the current revision
+	LEGACY_READONLY					// Records read from the legacy file (can't write)
+};
+
+typedef struct {
+	uint16_t slot;					// Record slot cached (PROF_NOITEM if empty)
+	uint16_t lastUse;				// LRU stamp
+	bool     modified;				// Record must be written before discarding it
+	ProfileItem_t item;
+} ProfileCache_t;
+
+typedef struct {					// ProfileHeaderData_t for revisions 2 & 3
+	uint8_t  itemsCount;
+	uint16_t itemLength;
+	bool     muteSound;
+} ProfileHeaderDataRev2_t;
+
+typedef struct {
+	uint16_t slot;
+	uint8_t  key[PROF_SORTKEY];		// Compared with memcmp
+} ProfileSortKey_t;
+
+typedef struct {
+	uint8_t  key[PROF_INDEXKEY];	// Uppercase description prefix, zero padded
+	uint16_t slot;
+} ProfileIndex_t;
+
+typedef struct {					// File directory entry values
+	uint16_t time;
+	uint16_t date;
+	uint32_t size;
+} ProfileStamp_t;
 
 
 // ========================================================
 // Private variables
 
-static char *filename = "A:\\OCMINFO.CFG";
+static char _path[PROF_PATHLEN];	// Persistent profiles file
+static char _mirror[PROF_PATHLEN];	// Working copy, if any
+static char *filename = _path;		// File in use: _path or _mirror
 static void *original_heaptop = NULL;
 
 static ProfileHeader_t _header = { PROF_MAGIC, PROF_REV, sizeof(ProfileHeaderData_t), 0x00 };
-static ProfileHeaderData_t _headerData = { 0, sizeof(ProfileItem_t), false };
-static ProfileItem_t *_profiles = NULL;
+static ProfileHeaderData_t _headerData = { 0, sizeof(ProfileItem_t), false, MAX_PROFILES, 0 };
+static FILEH _fh = FILE_CLOSED;
+static uint16_t *_order;			// Record slot for each list position
+static uint8_t *_usedSlots;			// Slots referenced by the saved or the current list
+static uint8_t *_freshSlots;		// Slots allocated since the last save
+static ProfileCache_t *_cache;
+static uint16_t _cacheTick;
+static uint16_t _maxItems;
+static uint16_t _fileSlots;			// Slots physically present in the file
+static uint32_t _recordsBase;		// File offset of slot 0
+static uint8_t _recordsSum;			// Checksum of listed records not pending to write
+static ProfileIndex_t *_index;		// Listed records sorted by description prefix
+static uint16_t _indexCount;
+static uint16_t *_view;				// List positions matching the current filter
+static bool _resolved;				// Paths already resolved
+static bool _resident;				// Store holds the file contents of '_stamp'
+static bool _modified;				// Store changed since the last load/save
+static ProfileStamp_t _stamp;
 static SYSTEMDATE_t date;
 
 
@@ -31,32 +100,116 @@ static SYSTEMDATE_t date;
 
 extern void getPanelsCmds(uint8_t *cmd);
 
-static bool _setFilenameWithBootDrive()
+static bool _readStamp(char *name, ProfileStamp_t *stamp)
 {
-	// Set the first drive available (boot drive)
-	RETW drives = availableDrives();
-	if (!drives) return false;
-	*filename = 'A';
-	while (drives && !(drives & 1)) {
-		drives >>= 1;
-		*filename++;
+	FFBLK *ffblk = malloc(sizeof(FFBLK));
+	bool found;
+
+	if (!ffblk) return false;
+	found = !dos2_findfirst(name, ffblk, ATTR_HIDDEN|ATTR_SYSTEM|ATTR_READONLY|ATTR_ARCHIVE);
+	if (found) {
+		stamp->time = ffblk->modifTime.raw;
+		stamp->date = ffblk->modifDate.raw;
+		stamp->size = ffblk->filesize;
 	}
-	return true;
+	free(sizeof(FFBLK));
+	return found;
 }
 
-static uint8_t _calculateChecksum()
+static bool _isStoreCurrent()
 {
-	uint8_t calculatedChecksum = 0;
-	uint16_t i;
-	// Calculate checksum for header data
-	for (i = 0; i < _header.headerLength; i++) {
-		calculatedChecksum += ((uint8_t*)&_headerData)[i];
+	// Unchanged store & file: nothing to read again
+	ProfileStamp_t stamp;
+
+	return _resident && !_modified && _fh != FILE_CLOSED &&
+		_readStamp(filename, &stamp) && !memcmp(&stamp, &_stamp, sizeof(ProfileStamp_t));
+}
+
+static void _setResident()
+{
+	_modified = false;
+	_resident = _readStamp(filename, &_stamp);
+}
+
+static bool _copyFile(FILEH src, char *dstName)
+{
+	// Whole file copy through a heap buffer
+	char *buffer = malloc(COPY_BUFFER);
+	uint32_t remain;
+	uint16_t len;
+	FILEH dst;
+	bool result = false;
+
+	if (!buffer) return false;
+	dos2_remove(dstName);
+	dst = dos2_fcreate(dstName, O_RDWR, ATTR_ARCHIVE|ATTR_HIDDEN);
+	if (dst < ERR_FIRST) {
+		remain = dos2_fseek(src, 0, SEEK_END);
+		dos2_fseek(src, 0, SEEK_SET);
+		while (remain) {
+			len = remain > COPY_BUFFER ? COPY_BUFFER : remain;
+			if (dos2_fread(buffer, len, src) != len || dos2_fwrite(buffer, len, dst) != len) break;
+			remain -= len;
+		}
+		result = !remain;
+		dos2_fclose(dst);
+		if (!result) dos2_remove(dstName);
+	}
+	free(COPY_BUFFER);
+	return result;
+}
+
+static bool _resolvePaths()
+{
+	ProfileStamp_t stamp;
+	FILEH fh;
+
+	if (_resolved) return true;
+
+	// Profiles file: OCMINFO environment item, or the boot drive root
+	if (dos2_getEnv(ENV_PROFILES, _path, PROF_PATHLEN) || !*_path) {
+		RETW drives = availableDrives();
+		if (!drives) return false;
+		strcpy(_path, "A:\\OCMINFO.CFG");
+		while (drives && !(drives & 1)) {
+			drives >>= 1;
+			(*_path)++;
+		}
 	}
-	// Calculate checksum for profile items
-	for (i = 0; i < _headerData.itemsCount * sizeof(ProfileItem_t); i++) {
-		calculatedChecksum += ((uint8_t*)_profiles)[i];
+
+	// Optional working copy: created from the persistent file at first use
+	filename = _path;
+	if (!dos2_getEnv(ENV_MIRROR, _mirror, PROF_PATHLEN) && *_mirror) {
+		if (_readStamp(_mirror, &stamp)) {
+			filename = _mirror;
+		} else {
+			fh = dos2_fopen(_path, O_RDONLY);
+			if (fh < ERR_FIRST) {
+				if (_copyFile(fh, _mirror)) filename = _mirror;
+				dos2_fclose(fh);
+			}
+		}
 	}
-	return calculatedChecksum;
+	_resolved = true;
+	return true;
+}
+
+static uint8_t _byteSum(void *data, uint16_t len)
+{
+	uint8_t sum = 0;
+	uint8_t *ptr = data;
+	while (len--) {
+		sum += *ptr++;
+	}
+	return sum;
+}
+
+static uint8_t _calculateChecksum()
+{
+	// Header data + order array + records (kept updated in _recordsSum)
+	return _byteSum(&_headerData, _header.headerLength) +
+		_byteSum(_order, _headerData.itemsCount * sizeof(uint16_t)) +
+		_recordsSum;
 }
 
 static bool _isValidChecksum()
@@ -65,98 +218,605 @@ static bool _isValidChecksum()
 	return (_calculateChecksum() == _header.checksum);
 }
 
+static bool _getBit(uint8_t *map, uint16_t slot)
+{
+	return (map[slot >> 3] & (1 << (slot & 7))) != 0;
+}
+
+static void _setBit(uint8_t *map, uint16_t slot, bool value)
+{
+	if (value) {
+		map[slot >> 3] |= 1 << (slot & 7);
+	} else {
+		map[slot >> 3] &= ~(1 << (slot & 7));
+	}
+}
+
+static void _trimSlots()
+{
+	// Forget free slots at the end of file
+	while (_headerData.slotsCount && !_getBit(_usedSlots, _headerData.slotsCount - 1)) {
+		_headerData.slotsCount--;
+	}
+}
+
+static uint16_t _firstFreeSlot()
+{
+	uint16_t slot;
+
+	for (slot = 0; slot < _headerData.slotsCount; slot++) {
+		if (!_getBit(_usedSlots, slot)) break;
+	}
+	return slot;
+}
+
+static uint16_t _allocSlot()
+{
+	uint16_t slot = _firstFreeSlot();
+
+	if (slot >= PROF_MAX_SLOTS) return PROF_NOITEM;
+	if (slot == _headerData.slotsCount) _headerData.slotsCount++;
+	_setBit(_usedSlots, slot, true);
+	_setBit(_freshSlots, slot, true);
+	return slot;
+}
+
+static void _seekSlot(uint16_t slot)
+{
+	dos2_fseek(_fh, _recordsBase + (uint32_t)slot * sizeof(ProfileItem_t), SEEK_SET);
+}
+
+static bool _writeSlot(uint16_t slot, ProfileItem_t *item)
+{
+	// Can't seek beyond the end of file: fill the gap with copies of the record
+	uint16_t pos = (slot < _fileSlots ? slot : _fileSlots);
+
+	_seekSlot(pos);
+	do {
+		if (dos2_fwrite((char*)item, sizeof(ProfileItem_t), _fh) != sizeof(ProfileItem_t))
+			return false;
+	} while (pos++ < slot);
+	if (pos > _fileSlots) _fileSlots = pos;
+	return true;
+}
+
+static bool _flushEntry(ProfileCache_t *entry)
+{
+	if (!entry->modified) return true;
+	if (_fh == FILE_CLOSED || !_writeSlot(entry->slot, &entry->item)) return false;
+	_recordsSum += _byteSum(&entry->item, sizeof(ProfileItem_t));
+	entry->modified = false;
+	return true;
+}
+
+static ProfileCache_t* _takeEntry()
+{
+	// Free entry or least recently used
+	ProfileCache_t *entry = _cache, *victim = _cache;
+	for (uint8_t i = 0; i < PROF_CACHE_SIZE; i++, entry++) {
+		if (entry->slot == PROF_NOITEM) {
+			victim = entry;
+			break;
+		}
+		if (entry->lastUse < victim->lastUse) victim = entry;
+	}
+	if (!_flushEntry(victim)) return NULL;
+	victim->slot = PROF_NOITEM;
+	victim->lastUse = ++_cacheTick;
+	return victim;
+}
+
+static ProfileCache_t* _fetchSlot(uint16_t slot)
+{
+	ProfileCache_t *entry = _cache;
+	uint8_t i;
+
+	for (i = 0; i < PROF_CACHE_SIZE; i++, entry++) {
+		if (entry->slot == slot) {
+			entry->lastUse = ++_cacheTick;
+			return entry;
+		}
+	}
+
+	entry = _takeEntry();
+	if (!entry) return NULL;
+	_seekSlot(slot);
+	if (dos2_fread((char*)&entry->item, sizeof(ProfileItem_t), _fh) != sizeof(ProfileItem_t))
+		return NULL;
+	entry->slot = slot;
+	return entry;
+}
+
+static char _upper(char c)
+{
+	return (c >= 'a' && c <= 'z') ? c - ('a' - 'A') : c;
+}
+
+static void _makeKey(uint8_t *key, char *text)
+{
+	uint8_t i = 0;
+	while (i < PROF_INDEXKEY && *text) {
+		key[i++] = _upper(*text++);
+	}
+	while (i < PROF_INDEXKEY) {
+		key[i++] = '\0';
+	}
+}
+
+static uint16_t _indexLowerBound(uint8_t *key, uint8_t len)
+{
+	// First index entry whose key is not lower than 'key' (binary search)
+	uint16_t lo = 0, hi = _indexCount, mid;
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		if (memcmp(_index[mid].key, key, len) < 0) lo = mid + 1; else hi = mid;
+	}
+	return lo;
+}
+
+static uint16_t _indexFind(uint16_t slot)
+{
+	ProfileIndex_t *entry = _index;
+	for (uint16_t pos = 0; pos < _indexCount; pos++, entry++) {
+		if (entry->slot == slot) return pos;
+	}
+	return PROF_NOITEM;
+}
+
+static void _indexInsert(ProfileItem_t *item, uint16_t slot)
+{
+	uint8_t key[PROF_INDEXKEY];
+	uint16_t pos;
+
+	_makeKey(key, item->description);
+	pos = _indexLowerBound(key, PROF_INDEXKEY);
+	if (pos < _indexCount) {
+		memmove(&_index[pos+1], &_index[pos], (_indexCount - pos) * sizeof(ProfileIndex_t));
+	}
+	memcpy(_index[pos].key, key, PROF_INDEXKEY);
+	_index[pos].slot = slot;
+	_indexCount++;
+}
+
+static void _indexRemove(uint16_t slot)
+{
+	uint16_t pos = _indexFind(slot);
+	if (pos == PROF_NOITEM) return;
+	_indexCount--;
+	if (pos < _indexCount) {
+		memcpy(&_index[pos], &_index[pos+1], (_indexCount - pos) * sizeof(ProfileIndex_t));
+	}
+}
+
+static void _indexSort()
+{
+	// Shell sort, used once after loading the records
+	ProfileIndex_t tmp;
+	uint16_t i, j, gap;
+
+	for (gap = _indexCount / 2; gap; gap /= 2) {
+		for (i = gap; i < _indexCount; i++) {
+			memcpy(&tmp, &_index[i], sizeof(ProfileIndex_t));
+			for (j = i; j >= gap && memcmp(_index[j-gap].key, tmp.key, PROF_INDEXKEY) > 0; j -= gap) {
+				memcpy(&_index[j], &_index[j-gap], sizeof(ProfileIndex_t));
+			}
+			memcpy(&_index[j], &tmp, sizeof(ProfileIndex_t));
+		}
+	}
+}
+
+static bool _matchPrefix(char *text, char *prefix)
+{
+	while (*prefix) {
+		if (_upper(*text++) != _upper(*prefix++)) return false;
+	}
+	return true;
+}
+
+static bool _scanRecords()
+{
+	// Checksum & index the listed records reading the file sequentially
+	ProfileItem_t *buffer = malloc(SCAN_RECORDS * sizeof(ProfileItem_t));
+	uint16_t slot = 0, len;
+	uint8_t i, count;
+	bool result = false;
+
+	if (!buffer) return false;
+	_seekSlot(0);
+	while (slot < _headerData.slotsCount) {
+		count = (_headerData.slotsCount - slot > SCAN_RECORDS) ? SCAN_RECORDS : _headerData.slotsCount - slot;
+		len = count * sizeof(ProfileItem_t);
+		if (dos2_fread((char*)buffer, len, _fh) != len) goto scan_end;
+		for (i = 0; i < count; i++, slot++) {
+			if (_getBit(_usedSlots, slot)) {
+				_recordsSum += _byteSum(&buffer[i], sizeof(ProfileItem_t));
+				_makeKey(_index[_indexCount].key, buffer[i].description);
+				_index[_indexCount++].slot = slot;
+			}
+		}
+	}
+	_fileSlots = slot;
+	_indexSort();
+	result = true;
+
+scan_end:
+	free(SCAN_RECORDS * sizeof(ProfileItem_t));
+	return result;
+}
+
+// Pointer to the file name part of a path
+static char* _baseName(char *path)
+{
+	char *name = path;
+	while (*path) {
+		if (*path == '\\' || *path == ':') name = path + 1;
+		path++;
+	}
+	return name;
+}
+
+// Renames a file in its own directory (MSX-DOS2 _RENAME)
+static ERRB _renameFile(char *path, char *newName) __naked __sdcccall(1)
+{
+	path;								// HL = Param path
+	newName;							// DE = Param newName
+	__asm
+		push ix
+		ex   de, hl						; DE = path, HL = new name
+		ld   c, #0x4e					; _RENAME
+		DOSCALL
+		pop  ix
+		ret								; Returns A = error code
+	__endasm;
+}
+
+static bool _createFile()
+{
+	dos2_remove(filename);
+	_fh = dos2_fcreate(filename, O_RDWR, ATTR_ARCHIVE|ATTR_HIDDEN);
+	if (_fh >= ERR_FIRST) {
+		_fh = FILE_CLOSED;
+		return false;
+	}
+	_fileSlots = 0;
+
+	// Reserve the whole order array, records start after it
+	_headerData.orderLength = MAX_PROFILES;
+	_recordsBase = sizeof(ProfileHeader_t) + sizeof(ProfileHeaderData_t) + MAX_PROFILES * sizeof(uint16_t);
+	dos2_fseek(_fh, sizeof(ProfileHeader_t) + sizeof(ProfileHeaderData_t), SEEK_SET);
+	return dos2_fwrite((char*)_order, MAX_PROFILES * sizeof(uint16_t), _fh) == MAX_PROFILES * sizeof(uint16_t);
+}
+
+static bool _openLegacyReadOnly(uint8_t *order, uint8_t count)
+{
+	// Read-only media: the records are read from the legacy file itself
+	uint16_t i;
+
+	_fh = dos2_fopen(filename, O_RDONLY);
+	if (_fh >= ERR_FIRST) {
+		_fh = FILE_CLOSED;
+		return false;
+	}
+	memset(_usedSlots, 0, SLOTS_BYTES * 2);
+	_recordsSum = 0;
+	for (i = 0; i < count; i++) {
+		if (order[i] >= count || _getBit(_usedSlots, order[i])) return false;
+		_setBit(_usedSlots, order[i], true);
+		_order[i] = order[i];
+	}
+	_recordsBase = sizeof(ProfileHeader_t) + sizeof(ProfileHeaderDataRev2_t);
+	_header.headerLength = sizeof(ProfileHeaderData_t);
+	_headerData.itemsCount = _headerData.slotsCount = _maxItems = count;
+	return true;
+}
+
+static uint8_t _migrateLegacyFile()
+{
+	// Revisions 2 & 3: all records loaded in memory, order array (rev.3) after them
+	ProfileHeaderDataRev2_t legacy;
+	ProfileItem_t *records;
+	uint8_t *order;
+	char tmpPath[PROF_PATHLEN], *tmpName, *legacyPath = filename;
+	uint16_t i, len;
+	uint8_t checksum;
+	uint8_t result = LEGACY_FAILED;
+
+	if (_header.headerLength != sizeof(ProfileHeaderDataRev2_t) ||
+		dos2_fread((char*)&legacy, sizeof(ProfileHeaderDataRev2_t), _fh) != sizeof(ProfileHeaderDataRev2_t) ||
+		legacy.itemsCount > LEGACY_MAX)
+	{
+		return LEGACY_FAILED;
+	}
+
+	len = legacy.itemsCount * sizeof(ProfileItem_t);
+	records = malloc(len + legacy.itemsCount);
+	if (!records) return LEGACY_FAILED;
+	order = (uint8_t*)records + len;
+	for (i = 0; i < legacy.itemsCount; i++) {
+		order[i] = i;
+	}
+	if (dos2_fread((char*)records, len, _fh) != len) goto migrate_end;
+	checksum = _byteSum(&legacy, sizeof(ProfileHeaderDataRev2_t)) + _byteSum(records, len);
+	if (_header.revision >= PROF_REV_ORDER) {
+		if (dos2_fread((char*)order, legacy.itemsCount, _fh) != legacy.itemsCount) goto migrate_end;
+		checksum += _byteSum(order, legacy.itemsCount);
+	}
+	if (checksum != _header.checksum) goto migrate_end;
+	dos2_fclose(_fh);
+	_fh = FILE_CLOSED;
+	_headerData.muteSound = legacy.muteSound;
+
+	// Write the current revision to a temporary file in the same directory,
+	// records in list order. The legacy file is untouched until it's saved.
+	strcpy(tmpPath, legacyPath);
+	tmpName = _baseName(tmpPath);
+	if (tmpName - tmpPath + sizeof(LEGACY_TMPNAME) > PROF_PATHLEN) goto migrate_readonly;
+	strcpy(tmpName, LEGACY_TMPNAME);
+	filename = tmpPath;
+	if (!_createFile()) goto migrate_readonly;
+	for (i = 0; i < legacy.itemsCount; i++) {
+		if (order[i] >= legacy.itemsCount || !_writeSlot(i, &records[order[i]])) goto migrate_discard;
+		_recordsSum += _byteSum(&records[order[i]], sizeof(ProfileItem_t));
+		_order[i] = i;
+	}
+	_headerData.itemsCount = _headerData.slotsCount = legacy.itemsCount;
+	if (!profile_saveFile()) goto migrate_discard;
+	dos2_fclose(_fh);
+	_fh = FILE_CLOSED;
+
+	// Replace the legacy file, restoring it if the converted one can't take its name
+	strcpy(tmpName, LEGACY_OLDNAME);
+	dos2_remove(tmpPath);
+	if (_renameFile(legacyPath, LEGACY_OLDNAME)) goto migrate_restore;
+	strcpy(tmpName, LEGACY_TMPNAME);
+	if (_renameFile(tmpPath, _baseName(legacyPath))) {
+		strcpy(tmpName, LEGACY_OLDNAME);
+		_renameFile(tmpPath, _baseName(legacyPath));
+		goto migrate_restore;
+	}
+	strcpy(tmpName, LEGACY_OLDNAME);
+	dos2_remove(tmpPath);
+	result = LEGACY_CONVERTED;
+	goto migrate_end;
+
+	// Can't be converted: the legacy file is still there, use it read-only
+migrate_discard:
+	if (_fh != FILE_CLOSED) dos2_fclose(_fh);
+	_fh = FILE_CLOSED;
+migrate_restore:
+	strcpy(tmpName, LEGACY_TMPNAME);
+	dos2_remove(tmpPath);
+migrate_readonly:
+	filename = legacyPath;
+	if (_openLegacyReadOnly(order, legacy.itemsCount)) result = LEGACY_READONLY;
+
+migrate_end:
+	filename = legacyPath;
+	free(len + legacy.itemsCount);
+	return result;
+}
+
+static int16_t _compareKeys(ProfileSortKey_t *a, ProfileSortKey_t *b, ProfileSort_t sortBy)
+{
+	int16_t result = memcmp(a->key, b->key, PROF_SORTKEY);
+
+	// Long descriptions with the same prefix: compare them full
+	if (!result && sortBy == PROF_SORT_NAME && a->key[PROF_SORTKEY-1]) {
+		char *descA = heap_top;
+		ProfileCache_t *entry = _fetchSlot(a->slot);
+		if (!entry) return 0;
+		strcpy(descA, entry->item.description);
+		entry = _fetchSlot(b->slot);
+		if (!entry) return 0;
+		result = strcmp(descA, entry->item.description);
+	}
+	return result;
+}
+
 
 // ========================================================
 // Functions
 
-void profile_init()
+static bool _allocStore()
 {
-	profile_release();
+	void *heaptop = heap_top;
+
+	if (!(_order = malloc(MAX_PROFILES * sizeof(uint16_t)))) return false;
+	if (!(_usedSlots = malloc(SLOTS_BYTES * 2))) goto alloc_order;
+	if (!(_index = malloc(MAX_PROFILES * sizeof(ProfileIndex_t)))) goto alloc_slots;
+	if (!(_view = malloc(MAX_PROFILES * sizeof(uint16_t)))) goto alloc_index;
+	if (!(_cache = malloc(PROF_CACHE_SIZE * sizeof(ProfileCache_t)))) goto alloc_view;
+	_freshSlots = _usedSlots + SLOTS_BYTES;
+	original_heaptop = heaptop;
+	return true;
+
+	// Not enough memory: release in reverse order
+alloc_view:
+	free(MAX_PROFILES * sizeof(uint16_t));
+alloc_index:
+	free(MAX_PROFILES * sizeof(ProfileIndex_t));
+alloc_slots:
+	free(SLOTS_BYTES * 2);
+alloc_order:
+	free(MAX_PROFILES * sizeof(uint16_t));
+	return false;
+}
+
+bool profile_init()
+{
+	if (_fh != FILE_CLOSED) dos2_fclose(_fh);
+	_fh = FILE_CLOSED;
+	_resident = _modified = false;
+	_header.revision = PROF_REV;
 	_header.headerLength = sizeof(ProfileHeaderData_t);
 	_headerData.itemsCount = 0;
 	_headerData.itemLength = sizeof(ProfileItem_t);
-	_header.checksum = _calculateChecksum();
+	_headerData.orderLength = MAX_PROFILES;
+	_headerData.slotsCount = 0;
+	_maxItems = MAX_PROFILES;
+	_fileSlots = 0;
+	_recordsBase = sizeof(ProfileHeader_t) + sizeof(ProfileHeaderData_t) + MAX_PROFILES * sizeof(uint16_t);
+	_recordsSum = 0;
+	_indexCount = 0;
 
-	original_heaptop = heap_top;
-	_profiles = (ProfileItem_t*)heap_top;
+	// Memory stays allocated until profile_release()
+	if (!original_heaptop && !_allocStore()) return false;
+	memset(_order, 0, MAX_PROFILES * sizeof(uint16_t));
+	memset(_usedSlots, 0, SLOTS_BYTES * 2);
+	for (uint8_t i = 0; i < PROF_CACHE_SIZE; i++) {
+		_cache[i].slot = PROF_NOITEM;
+		_cache[i].modified = false;
+	}
+	_header.checksum = _calculateChecksum();
+	return true;
 }
 
-inline void profile_release()
+void profile_release()
 {
+	if (_fh != FILE_CLOSED) dos2_fclose(_fh);
+	_fh = FILE_CLOSED;
+	_resident = false;
 	if (original_heaptop) heap_top = original_heaptop;
 	original_heaptop = NULL;
 }
 
-bool profile_loadFile()
+static bool _loadFile()
 {
-	bool result = false;
-	uint16_t profilesTotalLen = 0;
+	uint16_t i, slot;
 
-	if (!_setFilenameWithBootDrive()) return false;
+	if (_isStoreCurrent()) return true;
 
-	FILEH fh = dos2_fopen(filename, O_RDONLY);
-	if (fh >= ERR_FIRST) {
-		goto load_end;
+	if (!profile_init() || !_resolvePaths()) return false;
+
+	// Read-only media still allows to use the profiles
+	_fh = dos2_fopen(filename, O_RDWR);
+	if (_fh >= ERR_FIRST) _fh = dos2_fopen(filename, O_RDONLY);
+	if (_fh >= ERR_FIRST) {
+		_fh = FILE_CLOSED;
+		return false;
 	}
 
 	// Read header
-	if (dos2_fread((char*)&_header, sizeof(ProfileHeader_t), fh) != sizeof(ProfileHeader_t)) {
-		goto load_end;
+	if (dos2_fread((char*)&_header, sizeof(ProfileHeader_t), _fh) != sizeof(ProfileHeader_t)) {
+		goto load_fail;
 	}
 
-	// Read header data
-	if (dos2_fread((char*)&_headerData, _header.headerLength, fh) != _header.headerLength) {
-		goto load_end;
+	// Older revisions are converted to the current one
+	if (_header.revision < PROF_REV_PAGED) {
+		switch (_migrateLegacyFile()) {
+			case LEGACY_CONVERTED:
+				_resident = false;		// Read again the converted file
+				return _loadFile();
+			case LEGACY_READONLY:
+				// Checksum already verified with the legacy layout
+				if (!_scanRecords()) goto load_fail;
+				_header.checksum = _calculateChecksum();
+				_setResident();
+				return true;
+			default:
+				goto load_fail;
+		}
 	}
 
-	// Read profile items
-	profilesTotalLen = sizeof(ProfileItem_t) * _headerData.itemsCount;
-	_profiles = malloc(profilesTotalLen);
-	if (!_profiles || 
-		dos2_fread((char*)_profiles, profilesTotalLen, fh) != profilesTotalLen ||
-		!_isValidChecksum())
+	// Read header data
+	if (_header.revision != PROF_REV ||
+		_header.headerLength != sizeof(ProfileHeaderData_t) ||
+		dos2_fread((char*)&_headerData, sizeof(ProfileHeaderData_t), _fh) != sizeof(ProfileHeaderData_t))
+	{
+		goto load_fail;
+	}
+	_maxItems = _headerData.orderLength < MAX_PROFILES ? _headerData.orderLength : MAX_PROFILES;
+	_recordsBase = sizeof(ProfileHeader_t) + sizeof(ProfileHeaderData_t) + _headerData.orderLength * sizeof(uint16_t);
+	if (_headerData.itemsCount > _maxItems ||
+		_headerData.itemLength != sizeof(ProfileItem_t) ||
+		_headerData.slotsCount > PROF_MAX_SLOTS)
 	{
-		if (profilesTotalLen) profile_init();
-		goto load_end;
+		goto load_fail;
 	}
 
-	result = true;
+	// Read order array
+	if (dos2_fread((char*)_order, _headerData.itemsCount * sizeof(uint16_t), _fh) != _headerData.itemsCount * sizeof(uint16_t)) {
+		goto load_fail;
+	}
+	for (i = 0; i < _headerData.itemsCount; i++) {
+		slot = _order[i];
+		if (slot >= _headerData.slotsCount || _getBit(_usedSlots, slot)) goto load_fail;
+		_setBit(_usedSlots, slot, true);
+	}
+
+	// Check records
+	if (!_scanRecords() || !_isValidChecksum()) {
+		goto load_fail;
+	}
 
-load_end:
-	dos2_fclose(fh);
+	_setResident();
+	return true;
+
+load_fail:
+	profile_init();
+	return false;
+}
+
+bool profile_loadFile()
+{
+	PERF_BEGIN(PERF_LOADPROFILES);
+	bool result = _loadFile();
+	PERF_END(PERF_LOADPROFILES);
 	return result;
 }
 
 bool profile_saveFile()
 {
-	bool result = false;
+	ProfileCache_t *entry = _cache;
+	uint16_t i;
 
-	if (!_setFilenameWithBootDrive()) return false;
+	if (!original_heaptop) return false;
+	if (_fh == FILE_CLOSED) {
+		if (!_resolvePaths() || !_createFile()) return false;
+	}
 
-	ERRB err = dos2_remove(filename);
-	FILEH fh = dos2_fcreate(filename, O_WRONLY, ATTR_ARCHIVE|ATTR_HIDDEN);
-	if (fh >= ERR_FIRST) goto save_fail;
+	// Write modified records
+	for (i = 0; i < PROF_CACHE_SIZE; i++, entry++) {
+		if (!_flushEntry(entry)) return false;
+	}
 
-	// Write header
+	// Slots released since last save can be reused from now
+	memset(_usedSlots, 0, SLOTS_BYTES * 2);
+	for (i = 0; i < _headerData.itemsCount; i++) {
+		_setBit(_usedSlots, _order[i], true);
+	}
+	_trimSlots();
+
+	// Write order array
+	dos2_fseek(_fh, sizeof(ProfileHeader_t) + sizeof(ProfileHeaderData_t), SEEK_SET);
+	if (dos2_fwrite((char*)_order, _headerData.itemsCount * sizeof(uint16_t), _fh) != _headerData.itemsCount * sizeof(uint16_t))
+		return false;
+
+	// Write header & header data
 	_header.revision = PROF_REV;
 	_header.headerLength = sizeof(ProfileHeaderData_t);
 	_header.checksum = _calculateChecksum();
-	if (dos2_fwrite((char*)&_header, sizeof(ProfileHeader_t), fh) != sizeof(ProfileHeader_t))
-		goto save_fail;
+	dos2_fseek(_fh, 0, SEEK_SET);
+	if (dos2_fwrite((char*)&_header, sizeof(ProfileHeader_t), _fh) != sizeof(ProfileHeader_t) ||
+		dos2_fwrite((char*)&_headerData, sizeof(ProfileHeaderData_t), _fh) != sizeof(ProfileHeaderData_t))
+	{
+		return false;
+	}
 
-	// Write header data
-	if (dos2_fwrite((char*)&_headerData, _header.headerLength, fh) != _header.headerLength)
-		goto save_fail;
+	dos2_fflush(_fh);
+	_setResident();
 
-	// Write profile items
-	uint16_t profilesTotalLen = sizeof(ProfileItem_t) * _headerData.itemsCount;
-	if (dos2_fwrite((char*)_profiles, profilesTotalLen, fh) != profilesTotalLen)
-		goto save_fail;
+	// Write through to the persistent file
+	if (filename == _mirror) {
+		return _copyFile(_fh, _path);
+	}
+	return true;
+}
 
-	result = true;
-save_fail:
-	dos2_fclose(fh);
-	return result;
+bool profile_needsSave()
+{
+	// Every copy-on-write slot is taken until the next save releases them
+	return original_heaptop && _firstFreeSlot() >= PROF_MAX_SLOTS;
 }
 
 inline ProfileHeader_t* profile_getHeader()
@@ -169,16 +829,46 @@ inline ProfileHeaderData_t* profile_getHeaderData()
 	return &_headerData;
 }
 
-ProfileItem_t* profile_getItem(uint8_t idx)
+ProfileItem_t* profile_getItem(uint16_t idx)
+{
+	if (idx >= _headerData.itemsCount) return NULL;
+	ProfileCache_t *entry = _fetchSlot(_order[idx]);
+	return entry ? &entry->item : NULL;
+}
+
+ProfileItem_t* profile_editItem(uint16_t idx)
 {
 	if (idx >= _headerData.itemsCount) return NULL;
-	return &_profiles[idx];
+
+	uint16_t slot = _order[idx];
+	ProfileCache_t *entry = _fetchSlot(slot);
+	if (!entry) return NULL;
+
+	// Copy on write: the saved record is kept until the next save
+	if (!_getBit(_freshSlots, slot)) {
+		slot = _allocSlot();
+		if (slot == PROF_NOITEM) return NULL;
+		_index[_indexFind(entry->slot)].slot = slot;
+		entry->slot = _order[idx] = slot;
+	}
+	if (!entry->modified) {
+		_recordsSum -= _byteSum(&entry->item, sizeof(ProfileItem_t));
+		entry->modified = true;
+	}
+	_modified = true;
+	return &entry->item;
 }
 
-uint8_t profile_newItem()
+uint16_t profile_newItem()
 {
-	// Allocate & clean new profile
-	ProfileItem_t *newProfile = malloc(sizeof(ProfileItem_t));
+	if (_headerData.itemsCount >= _maxItems) return PROF_NOITEM;
+
+	// Get & clean new profile
+	ProfileCache_t *entry = _takeEntry();
+	if (!entry) return PROF_NOITEM;
+	uint16_t slot = _allocSlot();
+	if (slot == PROF_NOITEM) return PROF_NOITEM;
+	ProfileItem_t *newProfile = &entry->item;
 	memset(newProfile, 0, sizeof(ProfileItem_t));
 
 	// Set values
@@ -187,15 +877,20 @@ uint8_t profile_newItem()
 	newProfile->modifYear = date.year;
 	newProfile->modifMonth = date.month;
 	newProfile->modifDay = date.day;
+	entry->slot = slot;
+	entry->modified = true;
+	_indexInsert(newProfile, slot);
 
-	_headerData.itemsCount++;
-	return newProfile - _profiles;
+	// New record goes to the end of the list
+	_modified = true;
+	_order[_headerData.itemsCount] = slot;
+	return _headerData.itemsCount++;
 }
 
-bool profile_updateItem(uint8_t idx)
+bool profile_updateItem(uint16_t idx)
 {
 	// Get profile to update
-	ProfileItem_t *profile = profile_getItem(idx);
+	ProfileItem_t *profile = profile_editItem(idx);
 	if (profile == NULL) return false;
 
 	// Update values
@@ -204,22 +899,158 @@ bool profile_updateItem(uint8_t idx)
 	profile->modifYear = date.year;
 	profile->modifMonth = date.month;
 	profile->modifDay = date.day;
+	memset(&profile->bench, 0, sizeof(ProfileBench_t));	// Measured with the old values
+
+	return true;
+}
+
+bool profile_deleteItem(uint16_t idx)
+{
+	if (idx >= _headerData.itemsCount) return false;
+
+	uint16_t slot = _order[idx];
+	ProfileCache_t *entry = _fetchSlot(slot);
+	if (!entry) return false;
+
+	// Discard the record; a saved one is kept until the next save
+	if (!entry->modified) {
+		_recordsSum -= _byteSum(&entry->item, sizeof(ProfileItem_t));
+	}
+	entry->slot = PROF_NOITEM;
+	entry->modified = false;
+	_indexRemove(slot);
+	if (_getBit(_freshSlots, slot)) {
+		_setBit(_usedSlots, slot, false);
+		_setBit(_freshSlots, slot, false);
+		_trimSlots();
+	}
+
+	// Remove the list position
+	_modified = true;
+	_headerData.itemsCount--;
+	if (idx < _headerData.itemsCount) {
+		memcpy(&_order[idx], &_order[idx+1], (_headerData.itemsCount - idx) * sizeof(uint16_t));
+	}
+	return true;
+}
+
+bool profile_moveItem(uint16_t idx, int8_t moveTo)
+{
+	uint16_t dest = idx + moveTo;
+	if (idx >= _headerData.itemsCount || dest >= _headerData.itemsCount) return false;
 
+	uint16_t slot = _order[idx];
+	_order[idx] = _order[dest];
+	_order[dest] = slot;
+	_modified = true;
 	return true;
 }
 
-bool profile_deleteItem(uint8_t idx)
+bool profile_sortItems(ProfileSort_t sortBy)
 {
-	if (_headerData.itemsCount && idx < _headerData.itemsCount) {
-		if (idx+1 < _headerData.itemsCount) {
-			memcpy(
-				&_profiles[idx],
-				&_profiles[idx+1],
-				(_headerData.itemsCount-idx-1)*sizeof(ProfileItem_t));
+	uint16_t count = _headerData.itemsCount;
+	uint16_t keysLen = count * sizeof(ProfileSortKey_t);
+	ProfileSortKey_t *keys = malloc(keysLen + sizeof(ProfileSortKey_t));
+	ProfileSortKey_t *key, *tmp;
+	ProfileItem_t *profile;
+	uint16_t i, j, gap;
+	bool result = false;
+
+	if (!keys) return false;
+	tmp = &keys[count];
+
+	// Build sort keys, so records are read only once
+	for (i = 0, key = keys; i < count; i++, key++) {
+		if (!(profile = profile_getItem(i))) goto sort_end;
+		key->slot = _order[i];
+		if (sortBy == PROF_SORT_NAME) {
+			strncpy((char*)key->key, profile->description, PROF_SORTKEY);
+		} else {
+			// Newest first: inverted big endian date
+			memset(key->key, 0, PROF_SORTKEY);
+			key->key[0] = ~(profile->modifYear >> 8);
+			key->key[1] = ~(profile->modifYear & 0xff);
+			key->key[2] = ~profile->modifMonth;
+			key->key[3] = ~profile->modifDay;
 		}
-		_headerData.itemsCount--;
-		free(sizeof(ProfileItem_t));
-		return true;
 	}
-	return false;
+
+	// Shell sort over the keys, records never move
+	for (gap = count / 2; gap; gap /= 2) {
+		for (i = gap; i < count; i++) {
+			memcpy(tmp, &keys[i], sizeof(ProfileSortKey_t));
+			for (j = i; j >= gap && _compareKeys(&keys[j-gap], tmp, sortBy) > 0; j -= gap) {
+				memcpy(&keys[j], &keys[j-gap], sizeof(ProfileSortKey_t));
+			}
+			memcpy(&keys[j], tmp, sizeof(ProfileSortKey_t));
+		}
+	}
+	for (i = 0; i < count; i++) {
+		_order[i] = keys[i].slot;
+	}
+	_modified = true;
+	result = true;
+
+sort_end:
+	free(keysLen + sizeof(ProfileSortKey_t));
+	return result;
+}
+
+bool profile_indexItem(uint16_t idx)
+{
+	// Description changed: move the record to its new index position
+	ProfileItem_t *profile = profile_getItem(idx);
+	if (profile == NULL) return false;
+
+	_indexRemove(_order[idx]);
+	_indexInsert(profile, _order[idx]);
+	return true;
+}
+
+uint16_t profile_setFilter(char *prefix)
+{
+	uint8_t key[PROF_INDEXKEY];
+	uint8_t len = strlen(prefix);
+	uint16_t pos, count = 0;
+	ProfileCache_t *entry;
+	uint8_t *matches;
+
+	// Empty filter: whole list
+	if (!len) {
+		for (pos = 0; pos < _headerData.itemsCount; pos++) {
+			_view[pos] = pos;
+		}
+		return _headerData.itemsCount;
+	}
+
+	matches = malloc(SLOTS_BYTES);
+	if (!matches) return 0;
+	memset(matches, 0, SLOTS_BYTES);
+
+	// Matching keys are contiguous in the index; longer prefixes are checked against the record
+	_makeKey(key, prefix);
+	if (len > PROF_INDEXKEY) len = PROF_INDEXKEY;
+	for (pos = _indexLowerBound(key, len); pos < _indexCount; pos++) {
+		if (memcmp(_index[pos].key, key, len)) break;
+		if (prefix[len]) {
+			entry = _fetchSlot(_index[pos].slot);
+			if (entry == NULL || !_matchPrefix(entry->item.description, prefix)) continue;
+		}
+		_setBit(matches, _index[pos].slot, true);
+	}
+
+	// Keep the list order
+	for (pos = 0; pos < _headerData.itemsCount; pos++) {
+		if (_getBit(matches, _order[pos])) {
+			_view[count++] = pos;
+		}
+	}
+
+	free(SLOTS_BYTES);
+	return count;
+}
+
+uint16_t profile_getFilteredItem(uint16_t pos)
+{
+	return _view[pos];
 }
@@ -17,6 +17,8 @@
 #include "profiles_ui.h"
 #include "profiles_api.h"
 #include "dialogs.h"
+#include "blit80.h"
+#include "bench_quick.h"
 #include "strings_index.h"
 
 
@@ -27,6 +29,18 @@
 #define str(a) #a
 
 #define MAX_LINES		15
+#define FILTER_LEN		20
+#define ROW_LEN			76					// Visible chars of a list row
+#define ROW_STRIDE		(ROW_LEN + 1)		// Row + csprintf terminator
+#define ROW_CACHE		(MAX_LINES * 2)		// Preformatted rows kept
+#define ROW_BENCH		42					// Benchmark results column (descriptions are cut)
+#define ROW_EMPTY		0xffff
+
+#define LOG_ROWS		3					// Visible log lines
+#define LOG_FIRSTROW	(6+MAX_LINES)
+#define LOG_WIDTH		75
+#define LOG_STRIDE		80					// Room for csprintf output & terminator
+#define LOG_HISTORY		16					// Log lines kept
 
 #define NO_LOG			-1
 
@@ -36,14 +50,24 @@
 extern char *emptyArea;
 
 
-static uint8_t *itemsCount;
+static uint16_t *itemsCount;
 static uint8_t editPanelIdx;
-static uint8_t topLine = 0, currentLine = 0;
-static uint8_t newTopLine = 0, newCurrentLine = 0;
+static uint16_t topLine = 0, newTopLine = 0;
+static uint8_t currentLine = 0, newCurrentLine = 0;
 static uint16_t logIdx = NO_LOG;
 static uint8_t key;
 static bool redrawList, redrawSelection, doEditText;
+static int8_t movedTo;
+static char *rowCache;
+static uint16_t rowTag[ROW_CACHE];			// List position formatted in each cached row
+static char *logBuffer;						// Ring buffer of formatted log lines
+static uint16_t logCount;					// Log lines added (next line sequence)
+static uint8_t logScroll;					// Lines scrolled back through the history
+static uint16_t logShown[LOG_ROWS];			// Log line sequence shown at each row
 static bool changedProfiles;
+static ProfileSort_t nextSort = PROF_SORT_NAME;
+static char filterText[FILTER_LEN+1];
+static uint16_t filteredCount;
 static bool end;
 
 void beep_ok();
@@ -57,6 +81,9 @@ void setByteVRAM(uint16_t vram, uint8_t value) __sdcccall(0);
 void _fillVRAM(uint16_t vram, uint16_t len, uint8_t value) __sdcccall(0);
 
 void drawProfiles();
+bool drawRow(uint8_t line);
+void invalidateRows();
+void invalidateRow(uint16_t idx);
 void selectCurrentLine(bool enabled);
 
 // ========================================================
@@ -131,6 +158,16 @@ const Dialog_t dlg_saveChanges = {
 	DLG_DEFAULT
 };
 
+const uint16_t dlg_slotsFullStr[] = { DLG_SLOTSFULL_TITLE, DLG_SLOTSFULL_TEXT1, ARRAYEND };
+const Dialog_t dlg_slotsFull = {
+	0,0,
+	dlg_slotsFullStr,
+	dlg_yesNoBtn,
+	BTN_YES,	//defaultButton
+	BTN_NO,		//cancelButton
+	DLG_DEFAULT
+};
+
 const uint16_t dlg_deleteProfileStr[] = { DLG_DELETEPROFILE_TITLE, ARRAYEND };
 const Dialog_t dlg_deleteProfile = {
 	0,0,
@@ -174,7 +211,8 @@ const Dialog_t dlg_unmutedSound = {
 const uint16_t dlg_helpStr[] = {
 	DLG_PROFILESHELP_TITLE, DLG_PROFILESHELP_TEXT1, DLG_PROFILESHELP_TEXT2, DLG_PROFILESHELP_TEXT3,
 	DLG_PROFILESHELP_TEXT4, DLG_PROFILESHELP_TEXT5, DLG_PROFILESHELP_TEXT6, DLG_PROFILESHELP_TEXT7,
-	DLG_PROFILESHELP_TEXT8, DLG_PROFILESHELP_TEXT9, ARRAYEND
+	DLG_PROFILESHELP_TEXT13, DLG_PROFILESHELP_TEXT8, DLG_PROFILESHELP_TEXT9, DLG_PROFILESHELP_TEXT10,
+	DLG_PROFILESHELP_TEXT11, DLG_PROFILESHELP_TEXT12, ARRAYEND
 };
 const Dialog_t dlg_help = {
 	0,0,
@@ -189,12 +227,38 @@ const Dialog_t dlg_help = {
 // ========================================================
 // Functions
 
+uint16_t listIdx(uint16_t pos)
+{
+	// Translate a shown position to the list position
+	if (*filterText && pos < filteredCount) {
+		return profile_getFilteredItem(pos);
+	}
+	return pos;
+}
+
+void applyFilter()
+{
+	uint16_t pos;
+
+	filteredCount = profile_setFilter(filterText);
+	itemsCount = *filterText ? &filteredCount : &(profile_getHeaderData()->itemsCount);
+
+	// Keep the selection inside the filtered list
+	if (newTopLine + newCurrentLine >= *itemsCount) {
+		pos = *itemsCount ? *itemsCount - 1 : 0;
+		newTopLine = pos >= MAX_LINES ? pos - MAX_LINES + 1 : 0;
+		newCurrentLine = pos - newTopLine;
+	}
+}
+
 void drawProfilesCounter()
 {
-	csprintf(heap_top, "\x13 %s%u/"xstr(MAX_PROFILES)" \x14",
-		*itemsCount < 10 ? " ":"",
-		*itemsCount);
-	putlinexy(4,24, 9, heap_top);
+	uint16_t total = profile_getHeaderData()->itemsCount;
+	csprintf(heap_top, "\x13 %s%s%u/"xstr(MAX_PROFILES)" \x14",
+		total < 100 ? " ":"",
+		total < 10 ? " ":"",
+		total);
+	blit80_putline(4,24, 11, heap_top);
 }
 
 void drawHeader()
@@ -202,13 +266,15 @@ void drawHeader()
 	waitVBLANK();
 
 	// Clear panel
-	textblink(1,3, 80, false);
-	puttext(2,3, 79,23, emptyArea);
+	blit80_blink(1,3, 80, false);
+	blit80_puttext(2,3, 79,23, emptyArea);
 
 	// Panel keys topbar
 	Panel_t *panel = &pPanels[0];
 	while (panel->title != ARRAYEND) {
-		putlinexy(panel->titlex,panel->titley, panel->titlelen, getString(panel->title));
+		if (panel->titley) {
+			blit80_putline(panel->titlex,panel->titley, panel->titlelen, getString(panel->title));
+		}
 		panel++;
 	}
 
@@ -223,26 +289,83 @@ void drawHeader()
 	drawProfilesCounter();
 }
 
-void scrollupLog()
+void initLog()
+{
+	logCount = logScroll = 0;
+	memset(logShown, 0xff, sizeof(logShown));
+}
+
+char* getLogLine(uint16_t seq)
+{
+	return logBuffer + (seq % LOG_HISTORY) * LOG_STRIDE;
+}
+
+void drawLog()
 {
-	gettext(5,7+MAX_LINES, 79,23, heap_top);
-	puttext(5,6+MAX_LINES, 79,22, heap_top);
-	_fillVRAM(4+22*80, 75, ' ');
+	// Only rows showing a different line than before are written
+	uint16_t seq = logCount - LOG_ROWS - logScroll;
+	uint8_t i;
+
+	if (!logBuffer) return;
+	for (i = 0; i < LOG_ROWS; i++, seq++) {
+		if (logShown[i] == seq) continue;
+		logShown[i] = seq;
+		if (seq < logCount) {
+			blit80_putline(5,LOG_FIRSTROW+i, LOG_WIDTH, getLogLine(seq));
+		} else {
+			_fillVRAM(4+(LOG_FIRSTROW+i-1)*80, LOG_WIDTH, ' ');
+		}
+	}
+}
+
+char* newLogLine()
+{
+	// No memory for the log: lines are discarded (NULL)
+	if (!logBuffer) return NULL;
+	logScroll = 0;
+	return getLogLine(logCount++);
+}
+
+void endLogLine(char *line)
+{
+	// Pad with spaces so rows are drawn with a single blit80_putline
+	uint8_t len;
+
+	if (!line) return;
+	len = strlen(line);
+	if (len > LOG_WIDTH) len = LOG_WIDTH;
+	memset(line + len, ' ', LOG_WIDTH - len);
+	logShown[LOG_ROWS-1] = ROW_EMPTY;
+	drawLog();
 }
 
 void printLog(uint16_t log)
 {
-	scrollupLog();
-	putstrxy(5,23, getString(log));
+	char *line = newLogLine();
+	if (!line) return;
+	strcpy(line, getString(log));
+	endLogLine(line);
 }
 
 void printLogIdx(uint16_t logPattern)
 {
-	char *ptr = malloc(80);
-	csprintf(ptr, getString(logPattern), topLine + currentLine + 1);
-	scrollupLog();
-	putstrxy(5,23, ptr);
-	free(80);
+	char *line = newLogLine();
+	if (!line) return;
+	csprintf(line, getString(logPattern), listIdx(topLine + currentLine) + 1);
+	endLogLine(line);
+}
+
+void scrollLogHistory()
+{
+	// Go back one line, or return to the newest ones at the oldest kept
+	uint16_t kept = logCount < LOG_HISTORY ? logCount : LOG_HISTORY;
+	if (logScroll + LOG_ROWS < kept) {
+		logScroll++;
+	} else {
+		logScroll = 0;
+		beep_fail();
+	}
+	drawLog();
 }
 
 // ========================================================
@@ -252,14 +375,13 @@ inline bool isCtrlKeyPressed()
 }
 
 // ========================================================
-void editText(uint8_t itemNum)
+void editText(ProfileItem_t *item)
 {
-	ProfileItem_t *item = profile_getItem(itemNum);
 	bool end = false;
 	uint8_t pos = strlen(item->description);
 
-	putlinexy(5,newCurrentLine+5, 2, "<<");
-	putlinexy(6+sizeof(item->description),newCurrentLine+5, 2, ">>");
+	blit80_putline(5,newCurrentLine+5, 2, "<<");
+	blit80_putline(6+sizeof(item->description),newCurrentLine+5, 2, ">>");
 
 	gotoxy(7+pos, newCurrentLine + 5);
 	setcursortype(SOLIDCURSOR);
@@ -289,41 +411,91 @@ void editText(uint8_t itemNum)
 }
 
 // ========================================================
-void newProfile()
+// The copy-on-write slots run out after many changes, saving releases them
+bool saveToContinue()
 {
-	if (!*itemsCount) {
-		currentLine--;
+	if (!profile_needsSave()) return false;
+	if (showDialog(&dlg_slotsFull) != BTN_YES) return false;
+	printLog(LOG_PROF_SAVINGCFG);
+	if (!profile_saveFile()) {
+		showDialog(&dlg_errorSaving);
+		return false;
 	}
-	newCurrentLine = profile_newItem();
-	if (newCurrentLine >= MAX_LINES) {
-		newTopLine = newCurrentLine - MAX_LINES + 1;
-		newCurrentLine -= newTopLine;
+	changedProfiles = false;
+	return true;
+}
+
+bool newProfile()
+{
+	uint16_t pos = profile_newItem();
+	if (pos == PROF_NOITEM && saveToContinue()) pos = profile_newItem();
+	if (*filterText && pos != PROF_NOITEM) {
+		*filterText = '\0';
+		applyFilter();
+	}
+	if (pos == PROF_NOITEM) return false;
+	if (!pos) {
+		currentLine--;
 	}
+	newTopLine = (pos >= MAX_LINES ? pos - MAX_LINES + 1 : 0);
+	newCurrentLine = pos - newTopLine;
 	doEditText++;
+	invalidateRows();
 	redrawList++;
 	drawProfilesCounter();
+	return true;
 }
 
-void updateProfile()
+bool updateProfile()
 {
-	profile_updateItem(topLine + currentLine);
+	uint16_t idx = listIdx(topLine + currentLine);
+
+	if (!profile_updateItem(idx) && !(saveToContinue() && profile_updateItem(idx))) return false;
+	invalidateRow(listIdx(topLine + currentLine));
 	doEditText++;
 	redrawList++;
+	return true;
 }
 
-void moveCurrentProfile(int8_t moveTo)
+bool moveCurrentProfile(int8_t moveTo)
 {
-	ProfileItem_t *profile = profile_getItem(topLine+currentLine);
-	memcpy(heap_top, profile+moveTo, sizeof(ProfileItem_t));
-	memcpy(profile+moveTo, profile, sizeof(ProfileItem_t));
-	memcpy(profile, heap_top, sizeof(ProfileItem_t));
+	// Neighbours in a filtered list aren't neighbours in the profiles list
+	if (*filterText) {
+		beep_fail();
+		return false;
+	}
+	profile_moveItem(topLine+currentLine, moveTo);
+	invalidateRow(topLine+currentLine);
+	invalidateRow(topLine+currentLine+moveTo);
+	movedTo = moveTo;
+	changedProfiles = true;
+	return true;
+}
+
+void sortProfiles()
+{
+	if (!profile_sortItems(nextSort)) {
+		printLog(LOG_PROF_SORTERROR);
+		beep_error();
+		return;
+	}
+	if (*filterText) {
+		filteredCount = profile_setFilter(filterText);
+	}
+	logIdx = (nextSort == PROF_SORT_NAME ? LOG_PROF_SORTEDNAME : LOG_PROF_SORTEDDATE);
+	nextSort = (nextSort == PROF_SORT_NAME ? PROF_SORT_DATE : PROF_SORT_NAME);
+	invalidateRows();
 	redrawList++;
 	changedProfiles = true;
 }
 
 void deleteProfile()
 {
-	profile_deleteItem(topLine + currentLine);
+	profile_deleteItem(listIdx(topLine + currentLine));
+	invalidateRows();
+	if (*filterText) {
+		filteredCount = profile_setFilter(filterText);
+	}
 	if (!currentLine) {
 		if (topLine) {
 			newTopLine--;
@@ -341,54 +513,137 @@ void deleteProfile()
 
 void applyProfileCmds()
 {
-	uint8_t *cmd = profile_getItem(topLine+currentLine)->cmd;
+	uint8_t *cmd = profile_getItem(listIdx(topLine+currentLine))->cmd;
 	while (*cmd) {
 		ocm_sendSmartCmd(*cmd++);
 	}
 	resetCustomValues();
 }
 
+void benchmarkProfile()
+{
+	uint16_t idx = listIdx(topLine + currentLine);
+	ProfileBench_t bench;
+	ProfileItem_t *profile;
+
+	// Measured with the profile values applied
+	applyProfileCmds();
+	printLogIdx(LOG_PROF_BENCHRUNNING);
+	bench_quickRun(&bench);
+	profile = profile_editItem(idx);
+	if (!profile && saveToContinue()) profile = profile_editItem(idx);
+	if (!profile) {
+		printLogIdx(LOG_PROF_BENCHERROR);
+		beep_error();
+		return;
+	}
+	memcpy(&profile->bench, &bench, sizeof(ProfileBench_t));
+	invalidateRow(idx);
+	drawRow(currentLine);
+	logIdx = LOG_PROF_BENCHDONE;
+	redrawSelection++;
+	changedProfiles = true;
+}
+
 // ========================================================
+void invalidateRows()
+{
+	memset(rowTag, 0xff, sizeof(rowTag));
+}
+
+void invalidateRow(uint16_t idx)
+{
+	if (rowTag[idx % ROW_CACHE] == idx) {
+		rowTag[idx % ROW_CACHE] = ROW_EMPTY;
+	}
+}
+
+char* getRow(uint16_t idx)
+{
+	// Rows are formatted once and reused until the profile changes
+	uint8_t cached = idx % ROW_CACHE;
+	char *row = rowCache ? rowCache + cached * ROW_STRIDE : heap_top;
+	ProfileItem_t *profile;
+	uint16_t num = idx + 1;
+	uint8_t len;
+	char bench[BENCHQUICK_LEN + 1];
+
+	if (rowCache && rowTag[cached] == idx) return row;
+
+	profile = profile_getItem(idx);					// Records are paged from disk
+	if (!profile) return NULL;
+	memset(row, ' ', ROW_LEN);						// Fill with spaces
+	row[0] = num < 100 ? ' ' : '0'+num/100;			// Order number
+	row[1] = num < 10 ? ' ' : '0'+num/10%10;
+	row[2] = '0'+num%10;
+	bench_quickFormat(bench, &profile->bench);
+	len = strlen(profile->description);
+	if (*bench) {
+		if (len > ROW_BENCH - 6) len = ROW_BENCH - 6;
+		memcpy(row+ROW_BENCH, bench, strlen(bench));	// Benchmark results
+	}
+	memcpy(row+4, profile->description, len);		// Profile description
+	csprintf(row+66, "%u-%s%u-%s%u", 				// Date
+		profile->modifYear,
+		profile->modifMonth<10 ? "0":"", profile->modifMonth,
+		profile->modifDay<10 ? "0":"", profile->modifDay);
+	if (rowCache) rowTag[cached] = idx;
+	return row;
+}
+
+bool drawRow(uint8_t line)
+{
+	char *row = getRow(listIdx(topLine + line));
+	if (!row) return false;
+	blit80_putline(3,5+line, ROW_LEN, row);
+	return true;
+}
+
 void drawProfiles()
 {
-	ProfileItem_t *profile = profile_getItem(topLine);
-	uint8_t count = *itemsCount;
-	uint8_t i, num;
+	uint16_t count = *itemsCount - topLine;
+	uint8_t i;
 
 	if (count > MAX_LINES) count = MAX_LINES;
-	num = topLine + 1;
-	for (i = 0; i < count; i++, num++) {
-		memset(heap_top, ' ', 78);					// Fill with spaces
-		heap_top[0] = num < 10 ? ' ' : '0'+num/10;	// Order number
-		heap_top[1] = '0'+num%10;
-		memcpy(heap_top+4, 							// Profile description
-			profile->description, 
-			strlen(profile->description));
-		csprintf(heap_top+66, "%u-%s%u-%s%u", 		// Date
-			profile->modifYear,
-			profile->modifMonth<10 ? "0":"", profile->modifMonth,
-			profile->modifDay<10 ? "0":"", profile->modifDay);
-		putlinexy(3,5+i, 76, heap_top);
-		profile++;
+	for (i = 0; i < count; i++) {
+		if (!drawRow(i)) break;
 	}
 
 	if (i <= MAX_LINES) {
-		puttext(2,5+i, 79,4+MAX_LINES, emptyArea);
+		blit80_puttext(2,5+i, 79,4+MAX_LINES, emptyArea);
+	}
+}
+
+void scrollProfiles()
+{
+	// One line scrolls move the visible rows and draw only the new one
+	if (newTopLine == topLine + 1 && *itemsCount >= topLine + 1 + MAX_LINES) {
+		movetext(3,6, 2+ROW_LEN,4+MAX_LINES, 3,5);
+		topLine = newTopLine;
+		drawRow(MAX_LINES-1);
+	} else
+	if (newTopLine + 1 == topLine) {
+		movetext(3,5, 2+ROW_LEN,3+MAX_LINES, 3,6);
+		topLine = newTopLine;
+		drawRow(0);
+	} else {
+		topLine = newTopLine;
+		drawProfiles();
 	}
 }
 
 void selectCurrentLine(bool enabled)
 {
 	if (!*itemsCount && enabled) return;
-	textblink(2,5+currentLine, 78, enabled);
+	blit80_blink(2,5+currentLine, 78, enabled);
 }
 
 void selectPanel(uint8_t idx, bool enabled)
 {
 	Panel_t *panel = &pPanels[enabled ? PANEL_PROFILES : idx];
-	textblink(panel->titlex,panel->titley, panel->titlelen, false);
+	blit80_blink(panel->titlex,panel->titley, panel->titlelen, false);
 	panel = &pPanels[enabled ? idx : PANEL_PROFILES];
-	textblink(panel->titlex,panel->titley, panel->titlelen, true);
+	blit80_blink(panel->titlex,panel->titley, panel->titlelen, true);
 }
 
 void showDialogNoProfiles()
@@ -397,17 +652,75 @@ void showDialogNoProfiles()
 	showDialog(&dlg_noProfiles);
 }
 
+// ========================================================
+void filterProfiles()
+{
+	char *line = newLogLine();
+	uint8_t len = strlen(filterText);
+	bool done = false;
+
+	do {
+		// Show the filter being typed at the log line
+		if (line) {
+			csprintf(line, getString(LOG_PROF_FILTER), filterText);
+			endLogLine(line);
+		}
+
+		key = getch();
+		if (key == KEY_ENTER) {
+			done = true;
+			key = 0;
+		} else
+		if (key == KEY_ESC) {
+			len = 0;
+			done = true;
+		} else
+		if (key == KEY_DELETE || key == KEY_BS) {
+			if (len) len--; else key = 0;
+		} else
+		if (key >= 32 && key <= 254 && len < FILTER_LEN) {
+			filterText[len++] = key;
+		} else {
+			key = 0;
+		}
+		if (!key) {
+			if (!done) beep_fail();
+			continue;
+		}
+
+		// Narrow the list on each keystroke
+		filterText[len] = '\0';
+		newTopLine = newCurrentLine = 0;
+		applyFilter();
+		waitVBLANK();
+		selectCurrentLine(false);
+		topLine = currentLine = 0;
+		drawProfiles();
+		if (*itemsCount) selectCurrentLine(true);
+	} while (!done);
+
+	if (!len) printLog(LOG_PROF_FILTEROFF);
+	redrawSelection++;
+}
+
 // ========================================================
 void profiles_menu(Panel_t *panel)
 {
+	ProfileItem_t *editItem;
+
+	*filterText = '\0';
 	itemsCount = &(profile_getHeaderData()->itemsCount);
-	profile_init();
+	movedTo = 0;
+	invalidateRows();
+	rowCache = malloc(ROW_CACHE * ROW_STRIDE);
+	logBuffer = malloc(LOG_HISTORY * LOG_STRIDE);
+	initLog();
 
 	// Initialize header & profiles
 	newTopLine = newCurrentLine = topLine = currentLine = 0;
 	changedProfiles = doEditText = false;
 	drawHeader();
-	textblink(panel->titlex, panel->titley, panel->titlelen, true);
+	blit80_blink(panel->titlex, panel->titley, panel->titlelen, true);
 
 	// Read profile file & ask for creation if missing or corrupted
 	printLog(LOG_PROF_READINGFILE);
@@ -415,8 +728,7 @@ void profiles_menu(Panel_t *panel)
 		printLog(LOG_PROF_NOTFOUND);
 		beep_fail();
 		if (showDialog(&dlg_fileNotFound) == BTN_YES) {
-			profile_init();
-			if (!profile_saveFile()) {
+			if (!profile_init() || !profile_saveFile()) {
 				printLog(LOG_PROF_CANTCREATEFILE);
 				beep_error();
 				showDialog(&dlg_errorSaving);
@@ -452,11 +764,10 @@ void profiles_menu(Panel_t *panel)
 					} else {
 						if (topLine) {
 							newTopLine--;
-							redrawList++;
+							redrawSelection++;
 						}
 					}
-					if (isCtrlKeyPressed()) {
-						moveCurrentProfile(-1);
+					if (isCtrlKeyPressed() && moveCurrentProfile(-1)) {
 						logIdx = LOG_PROF_MOVEDUP;
 					}
 				} else beep_fail();
@@ -475,10 +786,9 @@ void profiles_menu(Panel_t *panel)
 						redrawSelection++;
 					} else {
 						newTopLine++;
-						redrawList++;
+						redrawSelection++;
 					}
-					if (isCtrlKeyPressed()) {
-						moveCurrentProfile(1);
+					if (isCtrlKeyPressed() && moveCurrentProfile(1)) {
 						logIdx = LOG_PROF_MOVEDOWN;
 					}
 				} else beep_fail();
@@ -514,9 +824,8 @@ void profiles_menu(Panel_t *panel)
 			redrawList++;
 		} else
 		if (key == 'A') {							// Add new profile
-			if (*itemsCount < MAX_PROFILES) {
+			if (newProfile()) {
 				editPanelIdx = PANEL_ADD;
-				newProfile();
 				logIdx = LOG_PROF_ADDEDNEW;
 			} else {
 				printLog(LOG_PROF_LIMITERROR);
@@ -528,8 +837,12 @@ void profiles_menu(Panel_t *panel)
 				showDialogNoProfiles();
 			} else {
 				editPanelIdx = PANEL_UPDATE;
-				updateProfile();
-				logIdx = LOG_PROF_UPDATED;
+				if (updateProfile()) {
+					logIdx = LOG_PROF_UPDATED;
+				} else {
+					printLogIdx(LOG_PROF_EDITERROR);
+					beep_fail();
+				}
 			}
 		} else 
 		if (key == KEY_DELETE) {					// Delete selection
@@ -557,6 +870,20 @@ void profiles_menu(Panel_t *panel)
 				redrawSelection++;
 			}
 		} else
+		if (key == 'R') {							// Run the quick benchmark
+			if (*itemsCount == 0) {
+				showDialogNoProfiles();
+			} else {
+				benchmarkProfile();
+			}
+		} else
+		if (key == 'S') {							// Sort profiles by name/date
+			if (*itemsCount == 0) {
+				showDialogNoProfiles();
+			} else {
+				sortProfiles();
+			}
+		} else
 		if (key == 'M') {							// Mute/unmute menu sounds
 			ProfileHeaderData_t *headerData = profile_getHeaderData();
 			headerData->muteSound = !(headerData->muteSound);
@@ -570,16 +897,40 @@ void profiles_menu(Panel_t *panel)
 			selectPanel(PANEL_HELP, false);
 			redrawSelection++;
 		} else
+		if (key == 'L') {							// Scroll back the log history
+			scrollLogHistory();
+		} else
+		if (key == 'F') {							// Filter profiles by name
+			filterProfiles();
+		} else
+		if (key == KEY_ESC && *filterText) {		// Remove filter
+			*filterText = '\0';
+			applyFilter();
+			redrawList++;
+			logIdx = LOG_PROF_FILTEROFF;
+		} else
 		if (key == KEY_ESC || key == 'B') {			// Go back to panels
 			end++;
 		}
 		// Update selection or full list if necessary
-		if (redrawList || redrawSelection) {
+		if (redrawList || redrawSelection || movedTo) {
 			waitVBLANK();
 			selectCurrentLine(false);
-			topLine = newTopLine;
+			if (redrawList) {
+				topLine = newTopLine;
+				drawProfiles();
+			} else
+			if (topLine != newTopLine) {
+				scrollProfiles();
+			}
 			currentLine = newCurrentLine;
-			if (redrawList) drawProfiles();
+			if (movedTo && !redrawList) {
+				// Only the two swapped rows changed
+				uint8_t other = currentLine - movedTo;
+				drawRow(currentLine);
+				if (other < MAX_LINES) drawRow(other);
+			}
+			movedTo = 0;
 			if (*itemsCount) selectCurrentLine(true);
 			redrawList = redrawSelection = false;
 			if (logIdx != NO_LOG) {
@@ -588,12 +939,31 @@ void profiles_menu(Panel_t *panel)
 			}
 		}
 		// Handle description editing if necessary
+		if (doEditText) {
+			editItem = profile_editItem(listIdx(topLine + currentLine));
+			if (!editItem && saveToContinue()) editItem = profile_editItem(listIdx(topLine + currentLine));
+		}
+		if (doEditText && !editItem) {
+			// No copy-on-write slot free, or the record can't be read
+			printLogIdx(LOG_PROF_EDITERROR);
+			beep_fail();
+			doEditText = false;
+		}
 		if (doEditText) {
 			printLogIdx(LOG_PROF_EDITING);
 			selectPanel(editPanelIdx, true);
 			beep_advice();
-			editText(topLine + currentLine);
+			editText(editItem);
+			profile_indexItem(listIdx(topLine + currentLine));
+			invalidateRow(listIdx(topLine + currentLine));
 			selectPanel(editPanelIdx, false);
+			if (*filterText) {
+				applyFilter();
+				selectCurrentLine(false);
+				topLine = newTopLine;
+				currentLine = newCurrentLine;
+				if (*itemsCount) selectCurrentLine(true);
+			}
 			drawProfiles();
 			printLog(LOG_PROF_MODIFIED);
 			beep_advice();
@@ -621,7 +991,8 @@ void profiles_menu(Panel_t *panel)
 
 	// Release memory & clear panel selection
 end_profile_menu:
-	profile_release();
-	textblink(panel->titlex, panel->titley, panel->titlelen, false);
+	if (logBuffer) free(LOG_HISTORY * LOG_STRIDE);
+	if (rowCache) free(ROW_CACHE * ROW_STRIDE);
+	blit80_blink(panel->titlex, panel->titley, panel->titlelen, false);
 }
 